@@ -1,5 +1,25 @@
 #include "p2d.hpp"
 
+// counts every heap allocation so the network benchmark can report them per message
+std::atomic<size_t> heapAllocations{0};
+
+void* operator new(size_t size)
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if(void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t /*size*/) noexcept
+{
+    std::free(p);
+}
+
 class ExampleApp : public Application
 {
 public:
@@ -12,7 +32,7 @@ public:
     void OnCreate() override
     {
         objs.push_back(new GameObject());
-        objs.at(objs.size() - 1)->AddComponent(new SpriteRenderer({0, 0, 218, 153}));
+        objs.at(objs.size() - 1)->AddComponent<SpriteRenderer>(Sprite(0, 0, 218, 153));
         AddObject(objs.at(objs.size() - 1));
     }
 
@@ -24,7 +44,7 @@ public:
             
             objs.push_back(new GameObject());
             objs.at(objs.size() - 1)->transform->position = {math.Random(-100, 100), math.Random(-100, 100)};
-            objs.at(objs.size() - 1)->AddComponent(new SpriteRenderer({0, 0, 218, 153}));
+            objs.at(objs.size() - 1)->AddComponent<SpriteRenderer>(Sprite(0, 0, 218, 153));
             AddObject(objs.at(objs.size() - 1));
             melons++;
             appName = (String)"melons: " + std::to_string(melons) + (String)" | " + std::to_string(time.frameRate * melons) + (String)" melons per second (m/s)";
@@ -78,8 +98,614 @@ public:
     int melons = 1;
 };
 
-int main()
+class BenchmarkScript : public Script
+{
+public:
+    BenchmarkScript() : Script() {}
+};
+
+// the lookup GameObject::GetComponent used before the type id table, kept here to compare against
+template <class T>
+T* ScanComponents(std::vector<Script*> &components)
+{
+    for(int i = 0; i < components.size(); i++)
+    {
+        if(dynamic_cast<T*>(components[i]) != nullptr) return (T*)components[i];
+    }
+    return nullptr;
+}
+
+void ComponentLookupBenchmark()
+{
+    const int objectCount = 10000;
+    const int iterations = 100;
+    std::vector<GameObject*> objects;
+    std::vector<std::vector<Script*>> scanComponents;
+    for(int i = 0; i < objectCount; i++)
+    {
+        GameObject* object = new GameObject();
+        std::vector<Script*> components = {object->transform};
+        components.push_back(object->AddComponent<BenchmarkScript>());
+        components.push_back(object->AddComponent<BenchmarkScript>());
+        components.push_back(object->AddComponent<Collider>());
+        components.push_back(object->AddComponent<SpriteRenderer>(Sprite(0, 0, 218, 153)));
+        objects.push_back(object);
+        scanComponents.push_back(components);
+    }
+
+    // the same three lookups the main loop does per object: drawable, collider and a missing rigidbody
+    size_t found = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for(int it = 0; it < iterations; it++)
+    {
+        for(int i = 0; i < objectCount; i++)
+        {
+            found += ScanComponents<Drawable>(scanComponents[i]) != nullptr;
+            found += ScanComponents<Collider>(scanComponents[i]) != nullptr;
+            found += ScanComponents<RigidBody>(scanComponents[i]) != nullptr;
+        }
+    }
+    auto scanTime = std::chrono::high_resolution_clock::now() - start;
+
+    start = std::chrono::high_resolution_clock::now();
+    for(int it = 0; it < iterations; it++)
+    {
+        for(int i = 0; i < objectCount; i++)
+        {
+            found += objects[i]->HasComponent<Drawable>();
+            found += objects[i]->HasComponent<Collider>();
+            found += objects[i]->HasComponent<RigidBody>();
+        }
+    }
+    auto tableTime = std::chrono::high_resolution_clock::now() - start;
+
+    float lookups = objectCount * iterations * 3.f;
+    std::cout << "component lookups: " << (int)lookups << " (" << found << " found)\n";
+    std::cout << " - dynamic_cast scan: " << std::chrono::duration<float, std::nano>(scanTime).count() / lookups << " ns per lookup\n";
+    std::cout << " - type id table:     " << std::chrono::duration<float, std::nano>(tableTime).count() / lookups << " ns per lookup\n";
+}
+
+// 100k objects that never move and 1k that move every tick, timed against rebuilding a quadtree from scratch each tick
+void BroadPhaseBenchmark()
 {
+    const int staticCount = 100000;
+    const int movingCount = 1000;
+    const int ticks = 100;
+    Math math;
+    std::vector<GameObject*> objects;
+    for(int i = 0; i < staticCount + movingCount; i++)
+    {
+        GameObject* object = new GameObject();
+        object->transform->position = {math.Random(-20000.f, 20000.f), math.Random(-20000.f, 20000.f)};
+        object->AddComponent<SpriteRenderer>(Sprite(0, 0, 32, 32));
+        object->_setInScene(true);
+        objects.push_back(object);
+    }
+    AABB view({0, 0}, {640 * 0.55f, 480 * 0.55f});
+    std::vector<GameObject*> inRange;
+
+    const char* names[] = {"quadtree", "grid"};
+    SpatialIndex* indexes[] = {new QuadTree({{0, 0}, {100000, 100000}}), new SpatialGridHash(64.f)};
+    for(int phase = 0; phase < 2; phase++)
+    {
+        for(int i = 0; i < objects.size(); i++)
+        {
+            objects[i]->_indexRemove();
+            objects[i]->_index(indexes[phase]);
+        }
+
+        GameObject::_refreshIndex(indexes[phase]);
+        size_t refreshed = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for(int tick = 0; tick < ticks; tick++)
+        {
+            for(int i = staticCount; i < objects.size(); i++)
+            {
+                objects[i]->transform->position.x += math.Random(-40.f, 40.f);
+                objects[i]->transform->position.y += math.Random(-40.f, 40.f);
+                objects[i]->transform->MarkMoved();
+            }
+            refreshed += Transform::_moved().size();
+            GameObject::_refreshIndex(indexes[phase]);
+            indexes[phase]->queryRange(view, inRange);
+        }
+        auto incrementalTime = std::chrono::high_resolution_clock::now() - start;
+        std::cout << names[phase] << " incremental refresh: " << std::chrono::duration<float, std::milli>(incrementalTime).count() / ticks << " ms per tick (" << inRange.size() << " in view)\n";
+
+        // with nothing moving the refresh shouldn't look at anything
+        start = std::chrono::high_resolution_clock::now();
+        for(int tick = 0; tick < ticks; tick++)
+        {
+            refreshed += Transform::_moved().size();
+            GameObject::_refreshIndex(indexes[phase]);
+        }
+        auto staticTime = std::chrono::high_resolution_clock::now() - start;
+        std::cout << names[phase] << " static refresh: " << std::chrono::duration<float, std::milli>(staticTime).count() / ticks << " ms per tick\n";
+        if(refreshed != (size_t)movingCount * ticks)
+        {
+            std::cout << "Error: the refresh visited " << refreshed << " transforms, only the " << movingCount * ticks << " moves should be\n";
+            exit(1);
+        }
+        if(staticTime * 10 > incrementalTime)
+        {
+            std::cout << "Error: refreshing a scene where nothing moved cost more than a tenth of refreshing the moving objects\n";
+            exit(1);
+        }
+    }
+
+    // what the refresh used to do: clear the tree and insert every object again
+    QuadTree qt({{0, 0}, {100000, 100000}});
+    auto start = std::chrono::high_resolution_clock::now();
+    for(int tick = 0; tick < ticks; tick++)
+    {
+        for(int i = staticCount; i < objects.size(); i++)
+        {
+            objects[i]->transform->position.x += math.Random(-40.f, 40.f);
+            objects[i]->transform->position.y += math.Random(-40.f, 40.f);
+        }
+        qt.clear();
+        for(int i = 0; i < objects.size(); i++)
+        {
+            qt.insert(objects[i], objects[i]->_bounds());
+        }
+        qt.queryRange(view, inRange);
+    }
+    auto rebuildTime = std::chrono::high_resolution_clock::now() - start;
+    std::cout << "quadtree full rebuild: " << std::chrono::duration<float, std::milli>(rebuildTime).count() / ticks << " ms per tick (" << inRange.size() << " in view)\n";
+}
+
+// a collision pass over 5k moving circles among 20k static ones, with the sweep and then the way _collide used to
+// do it, a quadtree range query per moving body and the narrow phase run on everything the query returned
+void CollisionBenchmark()
+{
+    const int staticCount = 20000;
+    const int movingCount = 5000;
+    const int ticks = 100;
+    Math math;
+    std::vector<Collider*> colliders;
+    for(int i = 0; i < staticCount + movingCount; i++)
+    {
+        GameObject* object = new GameObject();
+        object->transform->position = {math.Random(-8000.f, 8000.f), math.Random(-8000.f, 8000.f)};
+        object->AddComponent<SpriteRenderer>(Sprite(0, 0, 32, 32));
+        Collider* collider = object->AddComponent<Collider>();
+        collider->Type = Collider::Circle;
+        collider->Radius = 16;
+        collider->Centre = {0, 0};
+        collider->_isStatic = i < staticCount;
+        object->simulated = true;
+        object->_setInScene(true);
+        colliders.push_back(collider);
+    }
+
+    SweepAndPrune sweep;
+    size_t tests = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for(int tick = 0; tick < ticks; tick++)
+    {
+        for(int i = staticCount; i < colliders.size(); i++)
+        {
+            colliders[i]->transform->position.x += math.Random(-2.f, 2.f);
+            colliders[i]->transform->position.y += math.Random(-2.f, 2.f);
+            colliders[i]->transform->MarkMoved();
+        }
+        for(int i = 0; i < colliders.size(); i++)
+        {
+            Collider* collider = colliders[i];
+            if(collider->_sweepProxy == SpatialIndex::NoProxy) collider->_sweepProxy = sweep.Add(collider, collider->_worldBounds());
+            else sweep.Update(collider->_sweepProxy, collider->_worldBounds(), collider->_isStatic);
+        }
+        const std::vector<SweepAndPrune::Pair> &pairs = sweep.FindPairs();
+        for(int i = 0; i < pairs.size(); i++)
+        {
+            if(!pairs[i].a->_isStatic) pairs[i].a->_resolve(pairs[i].b);
+            else pairs[i].b->_resolve(pairs[i].a);
+        }
+        tests = pairs.size();
+    }
+    auto sweepTime = std::chrono::high_resolution_clock::now() - start;
+    std::cout << "sweep and prune: " << std::chrono::duration<float, std::milli>(sweepTime).count() / ticks << " ms per tick (" << tests << " narrow phase tests)\n";
+
+    QuadTree tree({{0, 0}, {100000, 100000}});
+    std::vector<GameObject*> nearby;
+    for(int i = 0; i < colliders.size(); i++)
+    {
+        colliders[i]->self->_index(&tree);
+    }
+    start = std::chrono::high_resolution_clock::now();
+    for(int tick = 0; tick < ticks; tick++)
+    {
+        for(int i = staticCount; i < colliders.size(); i++)
+        {
+            colliders[i]->transform->position.x += math.Random(-2.f, 2.f);
+            colliders[i]->transform->position.y += math.Random(-2.f, 2.f);
+            colliders[i]->transform->MarkMoved();
+        }
+        GameObject::_refreshIndex(&tree);
+        tests = 0;
+        for(int i = staticCount; i < colliders.size(); i++)
+        {
+            Collider* collider = colliders[i];
+            Vector2 pos = {collider->transform->position.x, collider->transform->position.y};
+            tree.queryRange({pos, {collider->Radius * 3.f, collider->Radius * 3.f}}, nearby);
+            for(int j = 0; j < nearby.size(); j++)
+            {
+                if(!nearby[j]->HasComponent<Collider>()) continue;
+                collider->_resolve(nearby[j]->GetComponent<Collider>());
+                tests++;
+            }
+        }
+    }
+    auto queryTime = std::chrono::high_resolution_clock::now() - start;
+    std::cout << "query per body: " << std::chrono::duration<float, std::milli>(queryTime).count() / ticks << " ms per tick (" << tests << " narrow phase tests)\n";
+}
+
+// fills the render batch with 10k sprites a frame, then again with them marked static, timed against a new vertex array grown one quad at a time
+void RenderBatchBenchmark()
+{
+    const int spriteCount = 10000;
+    const int frames = 100;
+    Math math;
+    std::vector<GameObject*> objects;
+    for(int i = 0; i < spriteCount; i++)
+    {
+        GameObject* object = new GameObject();
+        object->transform->position = {math.Random(-320.f, 320.f), math.Random(-240.f, 240.f)};
+        object->AddComponent<SpriteRenderer>(Sprite(0, 0, 32, 32));
+        objects.push_back(object);
+    }
+
+    RenderBatch batch;
+    unsigned int firstFrameGrowths = 0, laterGrowths = 0;
+    size_t laterAllocations = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for(int frame = 0; frame < frames; frame++)
+    {
+        size_t allocations = heapAllocations;
+        batch.Begin();
+        for(int i = 0; i < objects.size(); i++)
+        {
+            objects[i]->_render(&batch, nullptr);
+        }
+        if(frame == 0) firstFrameGrowths = batch.stats.growths;
+        else
+        {
+            laterGrowths += batch.stats.growths;
+            laterAllocations += heapAllocations - allocations;
+        }
+    }
+    auto batchTime = std::chrono::high_resolution_clock::now() - start;
+
+    // the same sprites kept in the static batch, which only checks their transform versions
+    for(int i = 0; i < objects.size(); i++)
+    {
+        objects[i]->GetComponent<SpriteRenderer>()->isStatic = true;
+    }
+    start = std::chrono::high_resolution_clock::now();
+    for(int frame = 0; frame < frames; frame++)
+    {
+        batch.Begin();
+        for(int i = 0; i < objects.size(); i++)
+        {
+            objects[i]->_render(&batch, nullptr);
+        }
+    }
+    auto staticTime = std::chrono::high_resolution_clock::now() - start;
+    unsigned int staticCount = batch.Statics()->Count();
+
+    // what the render loop used to do every frame
+    start = std::chrono::high_resolution_clock::now();
+    for(int frame = 0; frame < frames; frame++)
+    {
+        sf::VertexArray* va = new sf::VertexArray(sf::Quads, 0);
+        for(int i = 0; i < objects.size(); i++)
+        {
+            int prevVertices = va->getVertexCount();
+            va->resize(prevVertices + 4);
+            sf::Vertex* quad = &va[0][prevVertices];
+            quad[0].position = {objects[i]->transform->position.x, objects[i]->transform->position.y};
+        }
+        delete va;
+    }
+    auto vertexArrayTime = std::chrono::high_resolution_clock::now() - start;
+
+    std::cout << "render batch: " << std::chrono::duration<float, std::milli>(batchTime).count() / frames << " ms per frame, "
+              << firstFrameGrowths << " buffer growths on the first frame, " << laterGrowths << " on the " << frames - 1 << " after it with " << laterAllocations << " heap allocations\n";
+    std::cout << "static sprites: " << std::chrono::duration<float, std::milli>(staticTime).count() / frames << " ms per frame (" << staticCount << " cached)\n";
+    std::cout << "new vertex array: " << std::chrono::duration<float, std::milli>(vertexArrayTime).count() / frames << " ms per frame\n";
+}
+
+// a script with some per object work that only touches its own transform
+class WanderScript : public Script
+{
+public:
+    WanderScript() : Script()
+    {
+        threadSafe = true;
+    }
+
+    void Update() override
+    {
+        for(int i = 0; i < 200; i++)
+        {
+            angle += std::sin(angle + i) * 0.01f;
+        }
+        transform->position.x += std::cos(angle);
+        transform->position.y += std::sin(angle);
+        updates++;
+    }
+
+    float angle = 0;
+    int updates = 0;
+};
+
+// updates 20k objects a tick on the main thread, then spread over a JobSystem the way Application::multithreaded does
+void JobSystemBenchmark()
+{
+    const int objectCount = 20000;
+    const int ticks = 50;
+    std::vector<GameObject*> objects;
+    for(int i = 0; i < objectCount; i++)
+    {
+        GameObject* object = new GameObject();
+        object->AddComponent<WanderScript>()->angle = i;
+        objects.push_back(object);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for(int tick = 0; tick < ticks; tick++)
+    {
+        for(int i = 0; i < objects.size(); i++)
+        {
+            objects[i]->_update();
+        }
+    }
+    auto serialTime = std::chrono::high_resolution_clock::now() - start;
+
+    JobSystem jobs;
+    jobs.Start();
+    start = std::chrono::high_resolution_clock::now();
+    for(int tick = 0; tick < ticks; tick++)
+    {
+        jobs.ParallelFor(objects.size(), 32, [&objects](size_t begin, size_t end)
+        {
+            for(size_t i = begin; i < end; i++)
+            {
+                objects[i]->_update();
+            }
+        });
+    }
+    auto parallelTime = std::chrono::high_resolution_clock::now() - start;
+
+    std::cout << "main thread: " << std::chrono::duration<float, std::milli>(serialTime).count() / ticks << " ms per tick\n";
+    std::cout << "job system (" << jobs.ThreadCount() << " threads): " << std::chrono::duration<float, std::milli>(parallelTime).count() / ticks << " ms per tick\n";
+
+    // the broad phase finds children as well as their parents, the application only batches the roots since
+    // a parent's _update runs its children, so every script should run exactly once a tick
+    const int parentCount = 5000;
+    const int childCount = 3;
+    QuadTree tree({{0, 0}, {100000, 100000}});
+    std::vector<WanderScript*> scripts;
+    for(int i = 0; i < parentCount; i++)
+    {
+        GameObject* parent = new GameObject();
+        scripts.push_back(parent->AddComponent<WanderScript>());
+        for(int c = 0; c < childCount; c++)
+        {
+            GameObject* child = new GameObject();
+            scripts.push_back(child->AddComponent<WanderScript>());
+            parent->AddObject(child);
+        }
+        parent->_index(&tree);
+    }
+    std::vector<GameObject*> found, batch;
+    tree.queryRange(AABB({0, 0}, {1000, 1000}), found);
+    for(int i = 0; i < found.size(); i++)
+    {
+        if(found[i]->parent == nullptr) batch.push_back(found[i]);
+    }
+    start = std::chrono::high_resolution_clock::now();
+    for(int tick = 0; tick < ticks; tick++)
+    {
+        jobs.ParallelFor(batch.size(), 32, [&batch](size_t begin, size_t end)
+        {
+            for(size_t i = begin; i < end; i++)
+            {
+                batch[i]->_update();
+            }
+        });
+    }
+    auto hierarchyTime = std::chrono::high_resolution_clock::now() - start;
+    int wrong = 0;
+    for(int i = 0; i < scripts.size(); i++)
+    {
+        if(scripts[i]->updates != ticks) wrong++;
+    }
+    std::cout << "job system, " << parentCount << " objects with " << childCount << " children each: " << std::chrono::duration<float, std::milli>(hierarchyTime).count() / ticks << " ms per tick, "
+              << wrong << " of " << scripts.size() << " scripts not run once a tick\n";
+}
+
+enum class BenchmarkMessage : uint32_t
+{
+    ObjectUpdate
+};
+
+class EchoServer : public server_interface<BenchmarkMessage>
+{
+public:
+    EchoServer(uint16_t port) : server_interface<BenchmarkMessage>(port) {}
+
+protected:
+    bool onClientConnect(std::shared_ptr<Connection<BenchmarkMessage>> /*client*/) override
+    {
+        return true;
+    }
+
+    void onMessage(std::shared_ptr<Connection<BenchmarkMessage>> client, Message<BenchmarkMessage> &msg) override
+    {
+        messageClient(client, msg);
+    }
+};
+
+// echoes 100k object updates a second over loopback and counts heap allocations per message, first building them
+// field by field with pooling off, then with Message::build and the body pool
+void NetworkBenchmark()
+{
+    const size_t messagesPerSecond = 100000;
+    const size_t messageCount = 100000;
+    for(int pass = 0; pass < 2; pass++)
+    {
+        bool pooled = pass == 1;
+        BodyPool::setLimit(pooled ? 1024 : 0);
+        EchoServer server(60200 + pass);
+        server.start();
+        client_interface<BenchmarkMessage> client;
+        client.connect("127.0.0.1", 60200 + pass);
+        // give the handshake time to finish
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+        size_t sent = 0, received = 0;
+        size_t allocations = heapAllocations;
+        auto start = std::chrono::high_resolution_clock::now();
+        while(received < messageCount)
+        {
+            float elapsed = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count();
+            size_t due = std::min(messageCount, size_t(elapsed * messagesPerSecond));
+            for(; sent < due; sent++)
+            {
+                uint32_t id = sent;
+                float x = sent * 0.5f, y = sent * 0.25f, rotation = 0;
+                if(pooled)
+                {
+                    client.sendMessage(Message<BenchmarkMessage>::build(BenchmarkMessage::ObjectUpdate, id, x, y, rotation));
+                }
+                else
+                {
+                    Message<BenchmarkMessage> msg;
+                    msg.header.id = BenchmarkMessage::ObjectUpdate;
+                    msg << id << x << y << rotation;
+                    client.sendMessage(msg);
+                }
+            }
+            server.update();
+            while(!client.incoming().empty())
+            {
+                client.incoming().pop_front();
+                received++;
+            }
+            std::this_thread::yield();
+        }
+        auto time = std::chrono::high_resolution_clock::now() - start;
+        allocations = heapAllocations - allocations;
+
+        std::cout << (pooled ? "pooled bodies: " : "no pooling:    ") << (float)allocations / messageCount << " allocations per message, "
+            << std::chrono::duration<float, std::milli>(time).count() << " ms for " << messageCount << " echoed messages\n";
+        client.disconnect();
+    }
+}
+
+// snapshot sizes for a 10k object scene as more of it moves each tick, sent to a client that acknowledges every one
+void ReplicationBenchmark()
+{
+    const int objectCount = 10000;
+    const int ticks = 20;
+    Replicator server, client;
+    client.onSpawn = [](uint32_t /*id*/)
+    {
+        return new GameObject();
+    };
+    std::vector<GameObject*> objects;
+    for(int i = 0; i < objectCount; i++)
+    {
+        GameObject* object = new GameObject();
+        object->transform->position = {float(i % 100) * 10.f, float(i / 100) * 10.f};
+        server.Add(object);
+        objects.push_back(object);
+    }
+
+    Message<BenchmarkMessage> msg;
+    server.Capture();
+    server.Write(1, msg);
+    server.Acknowledge(1, client.Read(msg));
+    std::cout << "full snapshot of " << objectCount << " objects: " << msg.body.size() << " bytes\n";
+    for(int moving : {0, 10, 100, 1000, objectCount})
+    {
+        size_t bytes = 0;
+        for(int tick = 0; tick < ticks; tick++)
+        {
+            for(int i = 0; i < moving; i++)
+            {
+                objects[i]->transform->position.x += 1.5f;
+                objects[i]->transform->position.y -= 0.25f;
+                objects[i]->transform->MarkMoved();
+            }
+            server.Capture();
+            server.Write(1, msg);
+            server.Acknowledge(1, client.Read(msg));
+            bytes += msg.body.size();
+        }
+        std::cout << " - " << moving << " moving: " << bytes / ticks << " bytes per snapshot\n";
+    }
+
+    // a second client that only sees a screen sized area while everything moves
+    Replicator nearby;
+    nearby.onSpawn = client.onSpawn;
+    server.SetView(2, AABB({200, 200}, {200, 150}));
+    size_t bytes = 0;
+    for(int tick = 0; tick < ticks; tick++)
+    {
+        for(GameObject* object : objects)
+        {
+            object->transform->position.x += 1.5f;
+            object->transform->MarkMoved();
+        }
+        server.Capture();
+        server.Write(2, msg);
+        server.Acknowledge(2, nearby.Read(msg));
+        bytes += msg.body.size();
+    }
+    std::cout << " - " << objectCount << " moving, client with a 400x300 view: " << bytes / ticks << " bytes per snapshot\n";
+}
+
+int main(int argc, char** argv)
+{
+    // run ./benchmark components, broadphase, collision, render, jobs, network or replication to time those instead of the melon scene
+    if(argc > 1 && (String)argv[1] == "components")
+    {
+        ComponentLookupBenchmark();
+        return 0;
+    }
+    if(argc > 1 && (String)argv[1] == "broadphase")
+    {
+        BroadPhaseBenchmark();
+        return 0;
+    }
+    if(argc > 1 && (String)argv[1] == "collision")
+    {
+        CollisionBenchmark();
+        return 0;
+    }
+    if(argc > 1 && (String)argv[1] == "render")
+    {
+        RenderBatchBenchmark();
+        return 0;
+    }
+    if(argc > 1 && (String)argv[1] == "jobs")
+    {
+        JobSystemBenchmark();
+        return 0;
+    }
+    if(argc > 1 && (String)argv[1] == "network")
+    {
+        NetworkBenchmark();
+        return 0;
+    }
+    if(argc > 1 && (String)argv[1] == "replication")
+    {
+        ReplicationBenchmark();
+        return 0;
+    }
+
     ExampleApp app;
     app.frameRateLimit = 99999;
     app.vsync = false;
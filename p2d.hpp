@@ -18,9 +18,13 @@
 #include <istream>
 #include <ostream>
 #include <unordered_map>
+#include <unordered_set>
 #include <typeinfo>
 #include <typeindex>
 #include <mutex>
+#include <thread>
+#include <atomic>
+#include <random>
 #include <deque>
 #include <chrono>
 #include <SFML/Graphics.hpp>
@@ -148,2181 +152,6750 @@ struct Sprite
         size.y = height;
     }
 
+    // a whole image loaded through the TextureManager
+    Sprite(std::string image)
+    {
+        this->image = image;
+    }
+
+    // part of an image loaded through the TextureManager, pos is from the image's top left
+    Sprite(std::string image, int x, int y, int width, int height) : Sprite(x, y, width, height)
+    {
+        this->image = image;
+    }
+
     Vector2 pos;
+    // a size of 0 uses the whole image
     Vector2 size;
+    // empty for sprites in the application's spriteFilePath atlas
+    std::string image;
 };
 
-struct DebugObj
+struct AABB
 {
-    DebugObj() {}
-
-    sf::RectangleShape* rect = nullptr;
-    sf::CircleShape* circle = nullptr;
-    sf::Text* text = nullptr;
-    sf::VertexArray* va = nullptr;
-};
+    AABB() {}
 
+    AABB(Vector2 center, Vector2 halfDimension)
+    {
+        this->center = center;
+        this->halfDimension = halfDimension;
+    }
 
+    bool ContainsPoint(Vector2 point) const
+    {
+        return point.x >= center.x - halfDimension.x && point.x <= center.x + halfDimension.x &&
+               point.y >= center.y - halfDimension.y && point.y <= center.y + halfDimension.y;
+    }
 
-template <typename T>
-class server_interface;
-
-template <typename T>
-struct MessageHeader
-{
-    T id{};
-    uint32_t size = 0;
-};
-
-template <typename T>
- struct Message { MessageHeader<T> header{}; std::vector<uint8_t> body; std::size_t size() const { return sizeof(MessageHeader<T>) + body.size(); } friend std::ostream &operator << (std::ostream &os, const Message<T> &msg) { os << "ID: " << int(msg.header.id) << " Size: " << msg.header.size; return os; } template <typename DataType> friend Message<T> &operator << (Message<T> &msg, const DataType &data) { static_assert(std::is_standard_layout<DataType>::value, "Data is too complex to be sent"); size_t i = msg.body.size(); msg.body.resize(msg.body.size() + sizeof(DataType)); std::memcpy(msg.body.data() + i, &data, sizeof(DataType)); msg.header.size = msg.size(); return msg; } template <typename DataType> friend Message<T> &operator >> (Message<T> &msg, DataType &data) { static_assert(std::is_standard_layout<DataType>::value, "Data is too complex to be recieved"); size_t i = msg.body.size() - sizeof(DataType); std::memcpy(&data, msg.body.data() + i, sizeof(DataType)); msg.body.resize(i); msg.header.size = msg.size(); return msg; } };
-
-template <typename T>
-class Connection;
+    // true if other lies completely inside this box
+    bool Contains(const AABB &other) const
+    {
+        return other.center.x - other.halfDimension.x >= center.x - halfDimension.x &&
+               other.center.x + other.halfDimension.x <= center.x + halfDimension.x &&
+               other.center.y - other.halfDimension.y >= center.y - halfDimension.y &&
+               other.center.y + other.halfDimension.y <= center.y + halfDimension.y;
+    }
 
-template <typename T>
-struct OwnedMessage
-{
-    std::shared_ptr<Connection<T>> remote = nullptr;
-    Message<T> msg;
-    friend std::ostream &operator << (std::ostream &os, const OwnedMessage<T> &msg)
+    bool Intersects(const AABB &other) const
     {
-        os << msg.msg;
-        return os;
+        return std::abs(center.x - other.center.x) <= halfDimension.x + other.halfDimension.x &&
+               std::abs(center.y - other.center.y) <= halfDimension.y + other.halfDimension.y;
     }
+
+    Vector2 center;
+    Vector2 halfDimension;
 };
 
-template <typename T>
-class TsQueue
+// packs separate images into a few large atlas pages, so sprites from different files can still be drawn together
+class TextureManager
 {
 public:
-    TsQueue() = default;
-    TsQueue(const TsQueue<T>&) = delete;
-
-    virtual ~TsQueue()
+    struct Region
     {
-        clear();
-    }
+        // page 0 is the application's spriteFilePath atlas, packed pages start at 1
+        int page = 0;
+        Vector2 pos;
+        Vector2 size;
+    };
 
-    const T& front()
+    TextureManager() {}
+
+    // images loaded before the application starts are packed together when it does, later ones are packed straight away
+    bool Load(std::string name, std::string path)
     {
-        std::scoped_lock lock(muxQueue);
-        return deqQueue.front();
+        sf::Image image;
+        if(!image.loadFromFile(path))
+        {
+            std::cout << "Error: failed to load image from " << path << std::endl;
+            return false;
+        }
+        return Add(name, image);
     }
 
-    const T& back()
+    bool Add(std::string name, const sf::Image &image)
     {
-        std::scoped_lock lock(muxQueue);
-        return deqQueue.back();
+        if(regions.count(name) != 0)
+        {
+            std::cout << "Error: an image called " << name << " has already been loaded" << std::endl;
+            return false;
+        }
+        pending.push_back({name, image});
+        if(packed) _pack();
+        return true;
     }
 
-    void push_back(const T& item)
+    // returns nullptr until the image has been packed
+    const Region* Find(const std::string &name) const
     {
-        std::scoped_lock lock(muxQueue);
-        deqQueue.emplace_back(std::move(item));
-        std::unique_lock<std::mutex> ul(muxBlocking);
-        blocking.notify_one();
+        auto it = regions.find(name);
+        if(it == regions.end()) return nullptr;
+        return &it->second;
     }
 
-    void push_front(const T& item)
+    const sf::Texture* GetPage(int page) const
     {
-        std::scoped_lock lock(muxQueue);
-        deqQueue.emplace_front(std::move(item));
-        std::unique_lock<std::mutex> ul(muxBlocking);
-        blocking.notify_one();
+        if(page < 1 || page > (int)pages.size()) return nullptr;
+        return &pages[page - 1]->texture;
     }
 
-    bool empty()
+    int PageCount() const
     {
-        std::scoped_lock lock(muxQueue);
-        return deqQueue.empty();
+        return pages.size();
     }
 
-    size_t count()
+    void _pack()
     {
-        std::scoped_lock lock(muxQueue);
-        return deqQueue.size();
+        packed = true;
+        unsigned int size = std::min(pageSize, sf::Texture::getMaximumSize());
+        // tallest first, so each shelf wastes as little height as possible. sorted by index as images are slow to copy
+        std::vector<size_t> order(pending.size());
+        for(size_t i = 0; i < order.size(); i++)
+        {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [this](size_t a, size_t b)
+        {
+            return pending[a].image.getSize().y > pending[b].image.getSize().y;
+        });
+        for(size_t n = 0; n < order.size(); n++)
+        {
+            size_t i = order[n];
+            sf::Vector2u imageSize = pending[i].image.getSize();
+            // a pixel of padding on each side stops neighbouring images bleeding in when sprites are scaled
+            unsigned int w = imageSize.x + 2, h = imageSize.y + 2;
+            int page = -1;
+            unsigned int x = 0, y = 0;
+            if(w > size || h > size)
+            {
+                if(imageSize.x > sf::Texture::getMaximumSize() || imageSize.y > sf::Texture::getMaximumSize())
+                {
+                    std::cout << "Error: image " << pending[i].name << " is larger than the maximum texture size" << std::endl;
+                    continue;
+                }
+                // too big to share a page, so it gets one of its own
+                page = _newPage(std::min(w, sf::Texture::getMaximumSize()), std::min(h, sf::Texture::getMaximumSize()));
+                pages[page]->nextShelfY = pages[page]->height;
+                // the padding is dropped if the image is exactly the maximum size
+                x = w <= sf::Texture::getMaximumSize() ? 1 : 0;
+                y = h <= sf::Texture::getMaximumSize() ? 1 : 0;
+            }
+            for(int p = 0; p < (int)pages.size() && page == -1; p++)
+            {
+                Page* current = pages[p].get();
+                for(size_t s = 0; s < current->shelves.size(); s++)
+                {
+                    Shelf &shelf = current->shelves[s];
+                    if(h <= shelf.height && shelf.x + w <= current->width)
+                    {
+                        page = p;
+                        x = shelf.x + 1;
+                        y = shelf.y + 1;
+                        shelf.x += w;
+                        break;
+                    }
+                }
+                if(page == -1 && current->nextShelfY + h <= current->height && w <= current->width)
+                {
+                    page = p;
+                    x = 1;
+                    y = current->nextShelfY + 1;
+                    current->shelves.push_back({current->nextShelfY, h, w});
+                    current->nextShelfY += h;
+                }
+            }
+            if(page == -1)
+            {
+                page = _newPage(size, size);
+                x = 1;
+                y = 1;
+                pages[page]->shelves.push_back({0, h, w});
+                pages[page]->nextShelfY = h;
+            }
+            pages[page]->texture.update(pending[i].image, x, y);
+            Region region;
+            region.page = page + 1;
+            region.pos = {(float)x, (float)y};
+            region.size = {(float)imageSize.x, (float)imageSize.y};
+            regions[pending[i].name] = region;
+        }
+        pending.clear();
     }
 
-    void clear()
+    // the width and height of new atlas pages, only read when packing
+    unsigned int pageSize = 2048;
+
+private:
+    struct Shelf
     {
-        std::scoped_lock lock(muxQueue);
-        deqQueue.clear();
-    }
+        unsigned int y, height;
+        // where the next image on the shelf goes
+        unsigned int x;
+    };
 
-    T pop_front()
+    struct Page
     {
-        std::scoped_lock lock(muxQueue);
-        auto t = std::move(deqQueue.front());
-        deqQueue.pop_front();
-        return t;
-    }
+        sf::Texture texture;
+        unsigned int width, height;
+        std::vector<Shelf> shelves;
+        unsigned int nextShelfY = 0;
+    };
 
-    T pop_back()
+    struct PendingImage
     {
-        std::scoped_lock lock(muxQueue);
-        auto t = std::move(deqQueue.back());
-        deqQueue.pop_back();
-        return t;
-    }
+        std::string name;
+        sf::Image image;
+    };
 
-    void wait()
+    int _newPage(unsigned int width, unsigned int height)
     {
-        while(empty())
-        {
-            std::unique_lock<std::mutex> ul(muxBlocking);
-            blocking.wait(ul);
-        }
+        std::unique_ptr<Page> page = std::make_unique<Page>();
+        page->texture.create(width, height);
+        page->width = width;
+        page->height = height;
+        pages.push_back(std::move(page));
+        return pages.size() - 1;
     }
-    
-protected:
-    std::mutex muxQueue;
-    std::deque<T> deqQueue;
-    std::condition_variable blocking;
-    std::mutex muxBlocking;
+
+    std::unordered_map<std::string, Region> regions;
+    std::vector<std::unique_ptr<Page>> pages;
+    std::vector<PendingImage> pending;
+    bool packed = false;
 };
 
-template <typename T>
-class Connection : public std::enable_shared_from_this<Connection<T>>
+struct RenderStats
+{
+    // times one of the render batch's own buffers grew during the last frame, 0 once it fits the scene. a growth is
+    // where the batch allocates, though the sf::Text and RectangleShape it is given may allocate on their own
+    unsigned int growths = 0;
+    unsigned int vertices = 0;
+    unsigned int drawCalls = 0;
+    // static sprite vertices sent to the gpu during the last frame
+    unsigned int uploadedVertices = 0;
+};
+
+// quads for sprites that rarely change, kept in a vertex buffer on the gpu and only uploaded where they changed
+class StaticSpriteBatch
 {
 public:
-    enum class owner { server, client };
-    
-    Connection(owner parent, asio::io_context &asioContext, asio::ip::tcp::socket socket, TsQueue<OwnedMessage<T>> &qIn)
-    : m_asioContext(asioContext), m_socket(std::move(socket)), m_qMessagesIn(qIn)
+    StaticSpriteBatch() {}
+
+    uint32_t Add()
     {
-        m_ownerType = parent;
-        if(m_ownerType == owner::server)
+        uint32_t slot;
+        if(!freeSlots.empty())
         {
-            m_handshakeOut = uint64_t(std::chrono::system_clock::now().time_since_epoch().count());
-            m_handshakeCheck = scramble(m_handshakeOut);
+            slot = freeSlots.back();
+            freeSlots.pop_back();
         }
         else
         {
-            m_handshakeIn = 0;
-            m_handshakeOut = 0;
+            slot = vertices.size() / 4;
+            vertices.resize(vertices.size() + 4);
         }
+        count++;
+        return slot;
     }
 
-    virtual ~Connection() {} 
-    
-    uint32_t getID() const
+    // returns the quad for writing, it is uploaded the next time the batch is drawn
+    sf::Vertex* Edit(uint32_t slot)
     {
-        return id;
+        size_t first = slot * 4;
+        dirtyBegin = std::min(dirtyBegin, first);
+        dirtyEnd = std::max(dirtyEnd, first + 4);
+        return &vertices[first];
     }
-    
-    void connectToClient(server_interface<T>* server, uint32_t uid = 0)
+
+    void Remove(uint32_t slot)
     {
-        if(m_ownerType == owner::server)
+        // a quad with no area draws nothing, so the slot can stay in the buffer until it is reused
+        sf::Vertex* quad = Edit(slot);
+        for(int i = 0; i < 4; i++)
         {
-            if(m_socket.is_open())
-            {
-                id = uid;
-                writeValidation();
-                readValidation(server);
-            }
+            quad[i] = sf::Vertex();
         }
+        freeSlots.push_back(slot);
+        count--;
     }
 
-    bool connectToServer(const asio::ip::tcp::resolver::results_type &endpoints)
+    uint32_t Count() const
     {
-        if(m_ownerType == owner::client)
-        {
-            asio::async_connect(m_socket, endpoints, [this](std::error_code ec, asio::ip::tcp::endpoint endpoint)
-            {
-                if(!ec)
-                {
-                    readValidation();
-                }
-            });
-            return true;
-        }
-        return false;
+        return count;
     }
 
-    bool disconnect()
+    void Draw(sf::RenderWindow* window, sf::RenderStates state, RenderStats &stats)
     {
-        if(isConnected()) asio::post(m_asioContext, [this]()
+        if(count == 0)
         {
-            m_socket.close();
-        });
-        return true;
+            return;
+        }
+        if(!checkedAvailable)
+        {
+            // vertex buffers need a gl context, so they aren't created until there is a window to draw to
+            available = sf::VertexBuffer::isAvailable();
+            checkedAvailable = true;
+            if(available)
+            {
+                buffer = std::make_unique<sf::VertexBuffer>(sf::Quads, sf::VertexBuffer::Static);
+            }
+        }
+        if(!available)
+        {
+            window->draw(vertices.data(), vertices.size(), sf::Quads, state);
+            stats.drawCalls++;
+            return;
+        }
+        if(buffer->getVertexCount() < vertices.size())
+        {
+            // recreating the buffer loses its contents, so grow it with room to spare and upload everything
+            buffer->create(vertices.capacity());
+            buffer->update(vertices.data(), vertices.size(), 0);
+            stats.uploadedVertices += vertices.size();
+        }
+        else if(dirtyBegin < dirtyEnd)
+        {
+            buffer->update(&vertices[dirtyBegin], dirtyEnd - dirtyBegin, dirtyBegin);
+            stats.uploadedVertices += dirtyEnd - dirtyBegin;
+        }
+        dirtyBegin = SIZE_MAX;
+        dirtyEnd = 0;
+        window->draw(*buffer, 0, vertices.size(), state);
+        stats.drawCalls++;
     }
 
-    bool isConnected() const
-    {
-        return m_socket.is_open();
-    }
+private:
+    std::unique_ptr<sf::VertexBuffer> buffer;
+    // cpu copy of the buffer, also drawn directly when vertex buffers aren't supported
+    std::vector<sf::Vertex> vertices;
+    std::vector<uint32_t> freeSlots;
+    uint32_t count = 0;
+    size_t dirtyBegin = SIZE_MAX, dirtyEnd = 0;
+    bool available = false, checkedAvailable = false;
+};
 
-    bool send(const Message<T> &msg)
+// everything drawn in a frame, kept between frames so it only allocates while the scene grows
+class RenderBatch
+{
+public:
+    RenderBatch() {}
+
+    void Begin()
     {
-        asio::post(m_asioContext, [this, msg]()
+        stats = RenderStats();
+        for(size_t i = 0; i < pages.size(); i++)
         {
-            bool writingMessage = !m_qMessagesOut.empty();
-            m_qMessagesOut.push_back(msg);
-            if(!writingMessage) writeHeader();
-        });
-        return true;
+            pages[i].count = 0;
+        }
+        text.clear();
+        debugRectCount = 0;
     }
 
-    asio::ip::tcp::socket* getSocket()
+    // returns the 4 vertices of a new quad, only valid until the next call
+    // quads are bucketed by atlas page so each page is a single draw call
+    sf::Vertex* AddQuad(int page = 0)
     {
-        return &m_socket;
+        if(page >= (int)pages.size())
+        {
+            pages.resize(page + 1);
+            stats.growths++;
+        }
+        PageQuads &quads = pages[page];
+        if(quads.count + 4 > quads.vertices.size())
+        {
+            // the buffer never shrinks, so its size is the high-water mark of previous frames
+            quads.vertices.resize(std::max<size_t>(quads.vertices.size() * 2, 1024));
+            stats.growths++;
+        }
+        sf::Vertex* quad = &quads.vertices[quads.count];
+        quads.count += 4;
+        return quad;
     }
 
-private:
-    void readHeader()
+    StaticSpriteBatch* Statics(int page = 0)
     {
-        asio::async_read(m_socket, asio::buffer(&m_msgTemporaryIn.header, sizeof(MessageHeader<T>)), [this](std::error_code ec, std::size_t length)
+        while(page >= (int)statics.size())
         {
-            if(!ec)
-            {
-                if(m_msgTemporaryIn.header.size > 0)
-                {
-                    m_msgTemporaryIn.body.resize(m_msgTemporaryIn.header.size - sizeof(MessageHeader<T>));
-                    readBody();
-                }
-                else
-                {
-                    addToIncomingMessageQueue();
-                }
-            }
-            else
-            {
-                std::cout << "[" << id << "] Read Header Fail.\n";
-                m_socket.close();
-            }
-        });
+            statics.push_back(std::make_unique<StaticSpriteBatch>());
+            stats.growths++;
+        }
+        return statics[page].get();
     }
-    
-    void readBody()
+
+    // the text must stay alive until the batch is drawn
+    void AddText(const sf::Text* t)
     {
-        asio::async_read(m_socket, asio::buffer(m_msgTemporaryIn.body.data(), m_msgTemporaryIn.body.size()), [this](std::error_code ec, std::size_t length)
+        if(text.size() == text.capacity())
         {
-            if(!ec)
-            {
-                addToIncomingMessageQueue();
-            }
-            else
-            {
-                std::cout << "[" << id << "] Read Body Fail.\n";
-                m_socket.close();
-            }
-        });
+            stats.growths++;
+        }
+        text.push_back(t);
     }
 
-    void writeHeader()
+    sf::RectangleShape* AddDebugRect()
     {
-        asio::async_write(m_socket, asio::buffer(&m_qMessagesOut.front().header, sizeof(MessageHeader<T>)), [this](std::error_code ec, std::size_t length)
+        if(debugRectCount == debugRects.size())
         {
-            if(!ec)
-            {
-                if(m_qMessagesOut.front().body.size() > 0)
-                {
-                    writeBody();
-                }
-                else
-                {
-                    m_qMessagesOut.pop_front();
-                    if(!m_qMessagesOut.empty())
-                    {
-                        writeHeader();
-                    }
-                }
-            }
-            else
-            {
-                std::cout << "[" << id << "] Write Header Fail.\n";
-                m_socket.close();
-            }
-        });
+            debugRects.emplace_back();
+            stats.growths++;
+        }
+        return &debugRects[debugRectCount++];
     }
 
-    void writeBody()
+    // texture is the spriteFilePath atlas used by page 0, the rest of the pages come from textures
+    void Draw(sf::RenderWindow* window, const sf::Texture* texture, const TextureManager* textures)
     {
-        asio::async_write(m_socket, asio::buffer(m_qMessagesOut.front().body.data(), m_qMessagesOut.front().body.size()), [this](std::error_code ec, std::size_t length)
+        sf::RenderStates state = sf::RenderStates::Default;
+        // static sprites are usually backgrounds, so they go underneath everything else
+        for(size_t i = 0; i < statics.size(); i++)
         {
-            if(!ec)
-            {
-                m_qMessagesOut.pop_front();
-                if(!m_qMessagesOut.empty())
-                {
-                    writeHeader();
-                }
-            }
-            else
-            {
-                std::cout << "[" << id << "] Write Body Fail.\n";
-                m_socket.close();
-            }
-        });
+            state.texture = i == 0 ? texture : textures->GetPage((int)i);
+            statics[i]->Draw(window, state, stats);
+        }
+        for(size_t i = 0; i < pages.size(); i++)
+        {
+            if(pages[i].count == 0) continue;
+            state.texture = i == 0 ? texture : textures->GetPage((int)i);
+            window->draw(pages[i].vertices.data(), pages[i].count, sf::Quads, state);
+            stats.vertices += pages[i].count;
+            stats.drawCalls++;
+        }
+        for(size_t i = 0; i < text.size(); i++)
+        {
+            window->draw(*text[i]);
+            stats.drawCalls++;
+        }
+        for(size_t i = 0; i < debugRectCount; i++)
+        {
+            window->draw(debugRects[i]);
+            stats.drawCalls++;
+        }
     }
 
-    void addToIncomingMessageQueue()
-    {
-        if(m_ownerType == owner::server)
-        m_qMessagesIn.push_back({this->shared_from_this(), m_msgTemporaryIn});
-        else m_qMessagesIn.push_back({nullptr, m_msgTemporaryIn});
-        readHeader();
-    }
-    
-    uint64_t scramble(uint64_t input)
+    RenderStats stats;
+
+private:
+    struct PageQuads
     {
-        uint64_t out; input &= input >> 1; out = input ^ (input << 16) + 63512465; out *= out * 3; out += input << 16; out /= input; out++; out &= input ^ (input * (out ^ input)); out ^= 76225362; out ^= 0x01574185AB54; return out >> 16;
-    }
+        std::vector<sf::Vertex> vertices;
+        size_t count = 0;
+    };
 
-    void writeValidation()
+    std::vector<PageQuads> pages;
+    // one per page, behind pointers because sprites hold on to them
+    std::vector<std::unique_ptr<StaticSpriteBatch>> statics;
+    std::vector<const sf::Text*> text;
+    // a deque so that growing never moves the pooled rectangles
+    std::deque<sf::RectangleShape> debugRects;
+    size_t debugRectCount = 0;
+};
+
+
+
+template <typename T>
+class server_interface;
+
+template <typename T>
+struct MessageHeader
+{
+    T id{};
+    uint32_t size = 0;
+};
+
+// keeps the memory of finished message bodies so the next message can reuse it instead of allocating
+// each thread holds a few bodies to hand and swaps them with a shared pool in batches, so the lock is rarely taken
+class BodyPool
+{
+public:
+    // an empty body with room for at least capacity bytes
+    static std::vector<uint8_t> take(size_t capacity)
     {
-        asio::async_write(m_socket, asio::buffer(&m_handshakeOut, sizeof(uint64_t)), [this](std::error_code ec, std::size_t length)
+        std::vector<uint8_t> body;
+        Cache* local = cache();
+        if(local != nullptr)
         {
-            if(!ec)
-            {
-                if(m_ownerType == owner::client)
-                {
-                    readHeader();
-                }
-            }
-            else
+            if(local->bodies.empty()) refill(local->bodies);
+            if(!local->bodies.empty())
             {
-                m_socket.close();
+                body = std::move(local->bodies.back());
+                local->bodies.pop_back();
             }
-        });
+        }
+        body.reserve(capacity);
+        return body;
     }
 
-    void readValidation(server_interface<T>* server = nullptr)
+    // bodies that are too large, or that arrive when pooling is off, are left to free themselves
+    static void give(std::vector<uint8_t> &&body)
     {
-        asio::async_read(m_socket, asio::buffer(&m_handshakeIn, sizeof(uint64_t)), [this, server](std::error_code ec, std::size_t length)
-        {
-            if(!ec)
-            {
-                if(m_ownerType == owner::server)
-                {
-                    if(m_handshakeIn == m_handshakeCheck)
-                    {
-                        std::cout << "Client Validated" << std::endl;
-                        server->onClientValidated(this->shared_from_this());
-                        readHeader();
-                    }
-                    else
-                    {
-                        std::cout << "Client Disconnected (Fail Validation)" << std::endl;
-                        m_socket.close();
-                    }
-                }
-                else
-                {
-                    m_handshakeOut = scramble(m_handshakeIn);
-                    writeValidation();
-                }
-            }
-            else
-            {
-                std::cout << "Client Disconnected (readValidation)" << std::endl;
-                m_socket.close();
-            }
-        });
+        if(body.capacity() == 0 || body.capacity() > maxBodySize || limit() == 0) return;
+        Cache* local = cache();
+        if(local == nullptr) return;
+        body.clear();
+        local->bodies.push_back(std::move(body));
+        if(local->bodies.size() >= batchSize * 2) spill(local->bodies);
     }
-protected:
-    asio::ip::tcp::socket m_socket;
-    asio::io_context& m_asioContext;
-    TsQueue<Message<T>> m_qMessagesOut;
-    TsQueue<OwnedMessage<T>>& m_qMessagesIn;
-    Message<T> m_msgTemporaryIn;
-    owner m_ownerType = owner::server;
-    uint32_t id = 0;
-    uint64_t m_handshakeOut = 0;
-    uint64_t m_handshakeIn = 0;
-    uint64_t m_handshakeCheck = 0;
-};
 
-template<typename T>
-class client_interface
-{
-public:
-    client_interface() : m_socket(m_context) {}
-    
-    virtual ~client_interface()
+    // the most bodies kept in the shared pool, 0 turns pooling off
+    static void setLimit(size_t bodies)
     {
-        disconnect();
+        limit() = bodies;
     }
-    
-    bool connect(const std::string &host, const uint16_t port)
+
+private:
+    static constexpr size_t batchSize = 32;
+    static constexpr size_t maxBodySize = 16 * 1024;
+
+    struct Cache
     {
-        try
+        Cache()
         {
-            asio::ip::tcp::resolver resolver(m_context);
-            asio::ip::tcp::resolver::results_type endpoints = resolver.resolve(host, std::to_string(port));
-            m_connection = std::make_unique<Connection<T>>(Connection<T>::owner::client, m_context, asio::ip::tcp::socket(m_context), m_qMessagesIn);
-            m_connection->connectToServer(endpoints);
-            thrContext  = std::thread([this]() { m_context.run(); });
+            bodies.reserve(batchSize * 2);
         }
-        catch (std::exception e)
+
+        ~Cache()
         {
-            std::cerr << "Client Exception: " << e.what() << "\n";
-            return false;
+            destroyed() = true;
         }
-        return true;
-    }
-    
-    void disconnect()
+
+        std::vector<std::vector<uint8_t>> bodies;
+    };
+
+    struct Shared
     {
-        if(isConnected())
-        {
-            m_connection->disconnect();
-        }
-        m_context.stop();
-        if(thrContext.joinable()) thrContext.join();
-        m_connection.release();
-    }
-    
-    bool isConnected()
+        std::mutex mux;
+        std::vector<std::vector<uint8_t>> bodies;
+    };
+
+    static std::atomic<size_t>& limit()
     {
-        if(m_connection)
-        return m_connection->isConnected();
-        return false;
+        static std::atomic<size_t> bodies{1024};
+        return bodies;
     }
-    
-    bool sendMessage(const Message<T> &msg)
+
+    // messages can still be destroyed while a thread exits, after its cache has gone
+    static bool& destroyed()
     {
-        m_connection->send(msg);
-        return true;
+        thread_local bool gone = false;
+        return gone;
     }
 
-    TsQueue<OwnedMessage<T>>& incoming()
+    static Cache* cache()
     {
-        return m_qMessagesIn;
+        if(destroyed()) return nullptr;
+        thread_local Cache local;
+        return &local;
     }
-    
-protected:
-    asio::io_context m_context;
-    std::thread thrContext;
-    asio::ip::tcp::socket m_socket;
-    std::unique_ptr<Connection<T>> m_connection;
-
-private:
-    TsQueue<OwnedMessage<T>> m_qMessagesIn;
-};
 
-template <typename T>
-class server_interface
-{
-public:
-    server_interface(uint16_t port) : m_asioAcceptor(m_asioContext, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port)) {}
-    
-    virtual ~server_interface()
+    // never freed, so messages in static objects can still give their bodies back at exit
+    static Shared& shared()
     {
-        stop();
+        static Shared* pool = new Shared();
+        return *pool;
     }
-    
-    bool start()
+
+    static void refill(std::vector<std::vector<uint8_t>> &local)
     {
-        try
-        {
-            waitForClientConnection();
-            m_threadContext = std::thread([this]()
-            {
-                m_asioContext.run();
-            });
-        }
-        catch (std::exception e)
+        Shared& pool = shared();
+        std::scoped_lock lock(pool.mux);
+        for(size_t i = 0; i < batchSize && !pool.bodies.empty(); i++)
         {
-            std::cerr << "[SERVER] Exception: " << e.what() << "\n";
-            return false;
+            local.push_back(std::move(pool.bodies.back()));
+            pool.bodies.pop_back();
         }
-        std::cout << "[SERVER] Started\n";
-        return true;
-    }
-    
-    void stop()
-    {
-        m_asioContext.stop();
-        if(m_threadContext.joinable()) m_threadContext.join();
-        std::cout << "[SERVER] Stopped\n";
     }
 
-    void waitForClientConnection()
+    static void spill(std::vector<std::vector<uint8_t>> &local)
     {
-        m_asioAcceptor.async_accept([this](std::error_code ec, asio::ip::tcp::socket socket)
+        Shared& pool = shared();
         {
-            if(!ec)
-            {
-                std::cout << "[SERVER] New Connection: " << socket.remote_endpoint() << "\n";
-                std::shared_ptr<Connection<T>> newconn = std::make_shared<Connection<T>>(Connection<T>::owner::server, m_asioContext, std::move(socket), m_qMessagesIn);
-                if(this->onClientConnect(newconn))
-                {
-                    m_deqConnections.push_back(std::move(newconn));
-                    int id = generateUniqueID();
-                    m_deqConnections.back()->connectToClient(this, id);
-                    ids.push_back(id);
-                    std::cout << "[" << m_deqConnections.back()->getID() << "] Connection Approved\n";
-                }
-                else
-                {
-                    std::cout << "[-----] Connection Denied\n";
-                }
-            }
-            else
+            std::scoped_lock lock(pool.mux);
+            for(size_t i = 0; i < batchSize && pool.bodies.size() < limit(); i++)
             {
-                std::cout << "[SERVER] New Connection Error: " << ec.message() << "\n";
+                pool.bodies.push_back(std::move(local.back()));
+                local.pop_back();
             }
-            waitForClientConnection();
-        });
+        }
+        // the shared pool is full, these are freed
+        if(local.size() >= batchSize * 2) local.resize(batchSize);
     }
+};
 
-    void messageClient(std::shared_ptr<Connection<T>> client, const Message<T> &msg)
+template <typename T>
+struct Message
+{
+    MessageHeader<T> header{};
+    std::vector<uint8_t> body;
+
+    Message() = default;
+
+    Message(const Message<T> &other) : header(other.header), body(BodyPool::take(other.body.size()))
     {
-        if(client && client->isConnected())
-        {
-            client->send(msg);
-        }
-        else
-        {
-            this->onClientDisconnect(client);
-            client.reset();
-            std::cout << "Removing ID: " << std::to_string(client->getID()) << "\n";
-            ids.erase(std::remove(ids.begin(), ids.end(), client->getID()), ids.end());
-            m_deqConnections.erase(std::remove(m_deqConnections.begin(), m_deqConnections.end(), client), m_deqConnections.end());
-        }
+        body.assign(other.body.begin(), other.body.end());
     }
 
-    void messageAllClients(const Message<T> &msg, std::shared_ptr<Connection<T>> ignoreClient = nullptr)
+    Message(Message<T> &&other) = default;
+
+    // the body goes back to the pool for the next message to use
+    ~Message()
     {
-        bool invalidClientExists = false;
-        std::vector<int> idsToRemove;
-        for(auto &client : m_deqConnections)
-        {
-            if(client && client->isConnected())
-            {
-                if(client != ignoreClient) client->send(msg);
-            }
-            else
-            {
-                idsToRemove.push_back(client->getID());
-                this->onClientDisconnect(client);
-                client.reset();
-                invalidClientExists = true;
-            }
-        }
-        if(invalidClientExists)
-        {
-            std::sort(idsToRemove.begin(), idsToRemove.end());
-            for(size_t i = 0; i < ids.size(); i++)
-            {
-                if(std::binary_search(idsToRemove.begin(), idsToRemove.end(), ids[i]))
-                {
-                    std::swap(ids[i], ids[ids.size() - 1]);
-                    ids.pop_back();
-                }
-            }
-            m_deqConnections.erase(std::remove(m_deqConnections.begin(), m_deqConnections.end(), nullptr), m_deqConnections.end());
-        }
-    }  
+        BodyPool::give(std::move(body));
+    }
 
-    void update(size_t maxMessages = -1, bool wait = false)
+    Message<T> &operator = (const Message<T> &other)
     {
-        if(wait) m_qMessagesIn.wait();
-        size_t messageCount = 0;
-        while(messageCount < maxMessages && !m_qMessagesIn.empty())
-        {
-            auto msg = m_qMessagesIn.pop_front();
-            this->onMessage(msg.remote, msg.msg);
-            messageCount++;
-        }
+        header = other.header;
+        reserve(other.body.size());
+        body.assign(other.body.begin(), other.body.end());
+        return *this;
     }
 
-protected:
-    virtual bool onClientConnect(std::shared_ptr<Connection<T>> client)
+    Message<T> &operator = (Message<T> &&other)
     {
-        return false;
+        header = other.header;
+        BodyPool::give(std::move(body));
+        body = std::move(other.body);
+        return *this;
     }
 
-    virtual void onClientDisconnect(std::shared_ptr<Connection<T>> client)
+    // makes room for bytes more data so pushing it doesn't grow the body piece by piece
+    void reserve(size_t bytes)
     {
-        ids.erase(std::remove(ids.begin(), ids.end(), client->getID()), ids.end());
+        if(body.capacity() == 0) body = BodyPool::take(bytes);
+        else body.reserve(body.size() + bytes);
     }
-    
-    virtual void onMessage(std::shared_ptr<Connection<T>> client, Message<T> &msg) {}
-    
-public:
-    virtual void onClientValidated(std::shared_ptr<Connection<T>> client) {}
-    
-protected:
-    TsQueue<OwnedMessage<T>> m_qMessagesIn;
-    std::deque<std::shared_ptr<Connection<T>>> m_deqConnections;
-    asio::io_context m_asioContext;
-    std::thread m_threadContext;
-    asio::ip::tcp::acceptor m_asioAcceptor;
-    std::vector<int> ids;
 
-private:
-    int generateUniqueID()
+    // builds a message from its fields with the body sized once, they are pushed in order so pop them in reverse
+    template <typename... DataTypes>
+    static Message<T> build(T id, const DataTypes &...data)
     {
-        int id = std::chrono::system_clock::now().time_since_epoch().count();
-        while(count(ids, id) != false)
-        {
-            id = std::chrono::system_clock::now().time_since_epoch().count();
-        }
-        return id;
+        Message<T> msg;
+        msg.header.id = id;
+        msg.reserve((sizeof(DataTypes) + ... + 0));
+        (msg << ... << data);
+        return msg;
     }
-    
-    bool count(std::vector<int> vec, int i)
+
+    std::size_t size() const
     {
-        return std::count(vec.begin(), vec.end(), i);
+        return sizeof(MessageHeader<T>) + body.size();
     }
-};
 
+    friend std::ostream &operator << (std::ostream &os, const Message<T> &msg)
+    {
+        os << "ID: " << int(msg.header.id) << " Size: " << msg.header.size;
+        return os;
+    }
 
+    template <typename DataType>
+    friend Message<T> &operator << (Message<T> &msg, const DataType &data)
+    {
+        static_assert(std::is_standard_layout<DataType>::value, "Data is too complex to be sent");
+        size_t i = msg.body.size();
+        if(msg.body.capacity() == 0) msg.reserve(sizeof(DataType));
+        msg.body.resize(msg.body.size() + sizeof(DataType));
+        std::memcpy(msg.body.data() + i, &data, sizeof(DataType));
+        msg.header.size = msg.size();
+        return msg;
+    }
 
-typedef std::string String;
+    template <typename DataType>
+    friend Message<T> &operator >> (Message<T> &msg, DataType &data)
+    {
+        static_assert(std::is_standard_layout<DataType>::value, "Data is too complex to be recieved");
+        size_t i = msg.body.size() - sizeof(DataType);
+        std::memcpy(&data, msg.body.data() + i, sizeof(DataType));
+        msg.body.resize(i);
+        msg.header.size = msg.size();
+        return msg;
+    }
+};
 
+// a message that is never changed once built, so one copy can sit in the outgoing queue of every client it goes to
+template <typename T>
+using SharedMessage = std::shared_ptr<const Message<T>>;
 
+template <typename T>
+class Connection;
 
-class File
+template <typename T>
+struct OwnedMessage
 {
-public:
-    File() {}
-
-    File(std::vector<uint8_t> FileData)
+    std::shared_ptr<Connection<T>> remote = nullptr;
+    Message<T> msg;
+    friend std::ostream &operator << (std::ostream &os, const OwnedMessage<T> &msg)
     {
-        this->data = FileData;
+        os << msg.msg;
+        return os;
     }
+};
 
-    size_t Size() const
-    {
-        return data.size();
-    }
+// frames messages on the datagram channel: the connection's token, a sequence number, then the message
+// a datagram holding just the token tells the server where a client is sending from, the server answers with the same.
+// the token is random and only sent over tcp once the client has passed the handshake
+template <typename T>
+class Datagram
+{
+public:
+    static constexpr size_t prefixSize = sizeof(uint64_t) + sizeof(uint32_t);
+    // larger messages go over tcp, this keeps datagrams clear of fragmentation on most networks
+    static constexpr size_t maxSize = 1200;
 
-    template <typename DataType>
-    friend File &operator << (File &f, const DataType &d)
+    static bool fits(const Message<T> &msg)
     {
-        static_assert(std::is_standard_layout<DataType>::value, "Data is too complex to be saved");
-        size_t i = f.data.size();
-        f.data.resize(f.data.size() + sizeof(DataType));
-        std::memcpy(f.data.data() + i, &d, sizeof(DataType));
-        return f;
+        return prefixSize + msg.size() <= maxSize;
     }
 
-    template <typename DataType>
-    friend File &operator >> (File &f, DataType &d)
+    static void write(std::vector<uint8_t> &out, uint64_t token, uint32_t sequence, const Message<T> &msg)
     {
-        static_assert(std::is_standard_layout<DataType>::value, "Data is too complex to be loaded");
-        size_t i = f.data.size() - sizeof(DataType);
-        std::memcpy(&d, f.data.data() + i, sizeof(DataType));
-        f.data.resize(i);
-        return f;
+        out.resize(prefixSize + msg.size());
+        std::memcpy(out.data(), &token, sizeof(uint64_t));
+        std::memcpy(out.data() + sizeof(uint64_t), &sequence, sizeof(uint32_t));
+        std::memcpy(out.data() + prefixSize, &msg.header, sizeof(MessageHeader<T>));
+        if(!msg.body.empty()) std::memcpy(out.data() + prefixSize + sizeof(MessageHeader<T>), msg.body.data(), msg.body.size());
     }
 
-    std::vector<uint8_t>* Data()
+    static void writeToken(std::vector<uint8_t> &out, uint64_t token)
     {
-        return &data;
+        out.resize(sizeof(uint64_t));
+        std::memcpy(out.data(), &token, sizeof(uint64_t));
     }
 
-    void Save(std::string FilePath)
+    static bool readToken(const uint8_t *data, size_t size, uint64_t &token)
     {
-        std::ofstream out(FilePath, std::ios::out | std::ofstream::binary);
-        std::copy(data.begin(), data.end(), std::ostreambuf_iterator<char>(out));
-        out.close();
+        if(size < sizeof(uint64_t)) return false;
+        std::memcpy(&token, data, sizeof(uint64_t));
+        return true;
     }
 
-    void Load(std::string FilePath)
+    // false when there is no message or its header doesn't match the datagram's length
+    static bool read(const uint8_t *data, size_t size, uint32_t &sequence, Message<T> &msg)
     {
-        std::vector<uint8_t> data;
-        std::ifstream in(FilePath, std::ios::in | std::ifstream::binary);
-        std::istreambuf_iterator<char> iter{in};
-        std::istreambuf_iterator<char> end{};
-        std::copy(iter, end, std::back_inserter(data));
-        in.close();
-        this->data = data;
+        if(size < prefixSize + sizeof(MessageHeader<T>)) return false;
+        std::memcpy(&sequence, data + sizeof(uint64_t), sizeof(uint32_t));
+        std::memcpy(&msg.header, data + prefixSize, sizeof(MessageHeader<T>));
+        size_t bodySize = size - prefixSize - sizeof(MessageHeader<T>);
+        if(msg.header.size == 0 ? bodySize != 0 : msg.header.size != sizeof(MessageHeader<T>) + bodySize) return false;
+        msg.reserve(bodySize);
+        msg.body.assign(data + prefixSize + sizeof(MessageHeader<T>), data + size);
+        return true;
     }
-
-private:
-    std::vector<uint8_t> data;
 };
 
-class GameObject;
-
-class Chunk
+// what one end of the datagram channel knows about the other
+template <typename T>
+struct DatagramPeer
 {
-public:
-    Chunk() {}
-    ~Chunk() {}
-    
-    GameObject* objects[1024];
+    std::shared_ptr<Connection<T>> connection = nullptr;
+    // the tcp connection's address, datagrams from anywhere else are ignored
+    asio::ip::address address;
+    // pinned by the first registration
+    asio::ip::udp::endpoint endpoint;
+    bool hasEndpoint = false;
+    uint32_t nextSequence = 1;
+    // newest sequence received for each message id
+    std::unordered_map<uint32_t, uint32_t> newest;
+
+    // false for a message older than one already received with the same id
+    bool isNewest(T id, uint32_t sequence)
+    {
+        auto [it, inserted] = newest.try_emplace(uint32_t(id), sequence);
+        if(inserted) return true;
+        if(int32_t(sequence - it->second) <= 0) return false;
+        it->second = sequence;
+        return true;
+    }
 };
 
-class SpatialGridHash
+template <typename T>
+class TsQueue
 {
 public:
-    SpatialGridHash() {}
-    ~SpatialGridHash()
+    TsQueue() = default;
+    TsQueue(const TsQueue<T>&) = delete;
+
+    virtual ~TsQueue()
     {
         clear();
     }
-    
-    void Update()
+
+    const T& front()
     {
-        auto it = chunks.begin();
-        while(it != chunks.end())
-        {
-            Chunk* chunk = chunks.at(it->first);
-            for(int i = 0; i < 1024; i++)
-            {
-                if(chunk->objects[i] == nullptr) continue;
-                if(chunk->objects[i]->_chunkPos == GetChunkPos(chunk->objects[i])) continue;
-                Update(chunk->objects[i]);
-            }
-            it++;
-        }
+        std::scoped_lock lock(muxQueue);
+        return deqQueue.front();
     }
-    
-    void Update(GameObject* object)
+
+    const T& back()
     {
-        remove(object);
-        add(object);
+        std::scoped_lock lock(muxQueue);
+        return deqQueue.back();
     }
-    
-private:
-    std::map<std::pair<int, int>, Chunk*> chunks;
-};
-    
-class Time
-{
-public:
-    Time() {}
-    float deltaTime;
-    float time;
-    float frameRate;
-};
-
-class Math
-{
-public:
-    Math() {}
-    
-    double e = (double)2.7182818284590452353602874713527;
-    double pi = (double)3.141592654;
 
-    uint32_t Random()
+    void push_back(const T& item)
     {
-        lehmer += 0xe120fc15;
-        uint64_t tmp;
-        tmp = (uint64_t)lehmer * 0x4a39b70d;
-        uint32_t m1 = (tmp >> 32) ^ tmp;
-        tmp = (uint64_t)m1 * 0x12fad5c9;
-        uint32_t m2 = (tmp >> 32) ^ tmp;
-        return m2;
+        {
+            std::scoped_lock lock(muxQueue);
+            deqQueue.emplace_back(std::move(item));
+        }
+        std::unique_lock<std::mutex> ul(muxBlocking);
+        blocking.notify_one();
     }
 
-    int Random(int min, int max)
+    void push_back(T&& item)
     {
-        lehmer += 0xe120fc15;
-        uint64_t tmp;
-        tmp = (uint64_t)lehmer * 0x4a39b70d;
-        uint32_t m1 = (tmp >> 32) ^ tmp;
-        tmp = (uint64_t)m1 * 0x12fad5c9;
-        uint32_t m2 = (tmp >> 32) ^ tmp;
-        return (m2 % (max - min)) + min;
+        {
+            std::scoped_lock lock(muxQueue);
+            deqQueue.emplace_back(std::move(item));
+        }
+        std::unique_lock<std::mutex> ul(muxBlocking);
+        blocking.notify_one();
     }
 
-    float Random(float min, float max)
+    void push_front(const T& item)
     {
-        lehmer += 0xe120fc15;
-        uint64_t tmp;
-        tmp = (uint64_t)lehmer * 0x4a39b70d;
-        uint32_t m1 = (tmp >> 32) ^ tmp;
-        tmp = (uint64_t)m1 * 0x12fad5c9;
-        uint32_t m2 = (tmp >> 32) ^ tmp;
-        float result = m2 / MAX_FLOAT;
-        return (result * (max - min)) + min;
+        {
+            std::scoped_lock lock(muxQueue);
+            deqQueue.emplace_front(std::move(item));
+        }
+        std::unique_lock<std::mutex> ul(muxBlocking);
+        blocking.notify_one();
     }
 
-    double Random(double min, double max)
+    bool empty()
     {
-        lehmer += 0xe120fc15;
-        uint64_t tmp;
-        tmp = (uint64_t)lehmer * 0x4a39b70d;
-        uint32_t m1 = (tmp >> 32) ^ tmp;
-        tmp = (uint64_t)m1 * 0x12fad5c9;
-        uint32_t m2 = (tmp >> 32) ^ tmp;
-        double result = m2 / MAX_FLOAT;
-        return (result * (max - min)) + min;
+        std::scoped_lock lock(muxQueue);
+        return deqQueue.empty();
     }
 
-    void Seed(uint32_t seed)
+    size_t count()
     {
-        lehmer = seed;
+        std::scoped_lock lock(muxQueue);
+        return deqQueue.size();
     }
 
-    // float DotProduct(Vector2 VecA, Vector2 VecB)
-    // {
-    //     return (VecA.x * VecB.x) + (VecA.y * VecB.y);
-    // }
-
-    // float Magnitude(Vector2 Vec)
-    // {
-    //     return sqrt((Vec.x * Vec.x) + (Vec.y * Vec.y));
-    // }
-
-    Vector2 Rotate(Vector2 Vec, Vector2 Origin, float Angle)
+    const T& at(size_t index)
     {
-        float s = sin(Angle);
-        float c = cos(Angle);
-
-        Vec.Sub(Origin);
-
-        float x = Vec.x * c - Vec.y * s;
-        float y = Vec.x * s + Vec.y * c;
-
-        return {x + Origin.x, y + Origin.y};
+        std::scoped_lock lock(muxQueue);
+        return deqQueue.at(index);
     }
 
-    long double Sigmoid(double x)
+    void clear()
     {
-        return (long double)1.f / ((long double)1.f + (long double)std::pow((long double)e, (long double)-x));
+        std::scoped_lock lock(muxQueue);
+        deqQueue.clear();
     }
 
-    float Lerp(float src, float dst, float percent)
+    T pop_front()
     {
-        float tmp = dst - src;
-        tmp *= percent;
-        return src + tmp;
+        std::scoped_lock lock(muxQueue);
+        auto t = std::move(deqQueue.front());
+        deqQueue.pop_front();
+        return t;
     }
 
-    float Clamp(float value, float min, float max)
+    T pop_back()
     {
-        if(value < min) value = min;
-        if(value > max) value = max;
-        return value;
+        std::scoped_lock lock(muxQueue);
+        auto t = std::move(deqQueue.back());
+        deqQueue.pop_back();
+        return t;
     }
 
-private:
-    uint32_t lehmer = 0;
+    void wait()
+    {
+        // pushes notify under muxBlocking after the item is in, so checking under it can't miss one
+        std::unique_lock<std::mutex> ul(muxBlocking);
+        blocking.wait(ul, [this]() { return !empty(); });
+    }
+    
+protected:
+    std::mutex muxQueue;
+    std::deque<T> deqQueue;
+    std::condition_variable blocking;
+    std::mutex muxBlocking;
 };
 
-class Input
+// bounded lock free queue for many producers and one consumer, each slot carries a sequence number
+// that says whether it is ready to be written or read, so producers only race on the enqueue position
+template <typename T>
+class MpscQueue
 {
 public:
-    Input() {}
-
-    typedef sf::Keyboard::Key Key;
-    typedef sf::Mouse::Button MouseButton;
-
-    bool GetKey(int key)
+    MpscQueue(size_t capacity = 16384)
     {
-        if(keys.count(key) > 0)
+        size_t size = 2;
+        while(size < capacity) size <<= 1;
+        cells = std::make_unique<Cell[]>(size);
+        mask = size - 1;
+        for(size_t i = 0; i < size; i++)
         {
-            return keys.at(key);
+            cells[i].sequence.store(i, std::memory_order_relaxed);
         }
     }
 
-    bool GetKeyDown(int key)
+    MpscQueue(const MpscQueue<T>&) = delete;
+
+    // items still queued can own whatever is waiting on the queue, so they go while the waiters can still be cancelled
+    ~MpscQueue()
     {
-        if(keys.count(key) > 0)
-        {
-            return keysPressed[key];
-        }
+        cells.reset();
     }
 
-    bool GetKeyUp(int key)
+    // returns false when the queue is full
+    bool try_push(T&& item)
     {
-        if(keys.count(key) > 0)
+        Cell* cell;
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        while(true)
         {
-            return keysReleased[key];
+            cell = &cells[pos & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+            if(diff == 0)
+            {
+                if(enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if(diff < 0) return false;
+            else pos = enqueuePos.load(std::memory_order_relaxed);
         }
+        cell->value = std::move(item);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        wake();
+        return true;
     }
 
-    bool GetButton(int button)
+    // waits for the consumer to make room when full
+    void push_back(T&& item)
     {
-        if(buttons.count(button) > 0)
+        while(!try_push(std::move(item)))
         {
-            return buttons.at(button);
+            std::this_thread::yield();
         }
     }
 
-    bool GetButtonDown(int button)
+    void push_back(const T& item)
     {
-        if(buttons.count(button) > 0)
-        {
-            return buttonsPressed[button];
-        }
+        push_back(T(item));
     }
 
-    bool GetButtonUp(int button)
+    // only the consumer thread may call the functions below
+    bool try_pop(T& item)
     {
-        if(buttons.count(button) > 0)
-        {
-            return buttonsReleased[button];
-        }
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Cell& cell = cells[pos & mask];
+        if(cell.sequence.load(std::memory_order_acquire) != pos + 1) return false;
+        item = std::move(cell.value);
+        cell.sequence.store(pos + mask + 1, std::memory_order_release);
+        dequeuePos.store(pos + 1, std::memory_order_relaxed);
+        resumeWaiters();
+        return true;
     }
 
-    Vector2 GetMousePos()
+    // check empty() first
+    T pop_front()
     {
-        return mousePos;
+        T item;
+        try_pop(item);
+        return item;
     }
 
-    float GetMouseX()
+    // moves up to max items onto the end of out and returns how many
+    size_t pop_all(std::vector<T>& out, size_t max = -1)
     {
-        return mousePos.x;
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        size_t count = 0;
+        while(count < max)
+        {
+            Cell& cell = cells[pos & mask];
+            if(cell.sequence.load(std::memory_order_acquire) != pos + 1) break;
+            out.emplace_back(std::move(cell.value));
+            cell.sequence.store(pos + mask + 1, std::memory_order_release);
+            pos++;
+            count++;
+        }
+        dequeuePos.store(pos, std::memory_order_relaxed);
+        if(count > 0) resumeWaiters();
+        return count;
     }
 
-    float GetMouseY()
+    bool empty()
     {
-        return mousePos.y;
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        return cells[pos & mask].sequence.load(std::memory_order_acquire) != pos + 1;
     }
 
-    float GetMouseWheel()
+    size_t count()
     {
-        return scrollWheel;
+        return enqueuePos.load(std::memory_order_relaxed) - dequeuePos.load(std::memory_order_relaxed);
     }
 
-    std::string GetTextTyped()
+    size_t capacity()
     {
-        return text;
+        return mask + 1;
     }
 
-    void _update()
+    void clear()
     {
-        for(int i = 0; i < Key::KeyCount; i++)
-        {
-            keysPressed[i] = false;
-            keysReleased[i] = false;
-        }
-
-        for(int i = 0; i < MouseButton::ButtonCount; i++)
-        {
-            buttonsPressed[i] = false;
-            buttonsReleased[i] = false;
-        }
-        text = "";
+        T item;
+        while(try_pop(item));
     }
 
-    void _poll(sf::Event event)
+    // for a producer that found the queue full, the consumer calls resume once it has popped something. resume runs
+    // with the waiters locked, so it should only hand the work off. check has_space() afterwards, in case the consumer
+    // made room before the wait was registered
+    void wait_for_space(const void* waiter, std::function<void()> resume)
     {
-        switch(event.type)
-        {
-            case sf::Event::KeyPressed:
-            {
-                keys.at(event.key.code) = true;
-                keysPressed.at(event.key.code) = true;
-                break;
-            }
-            case sf::Event::KeyReleased:
-            {
-                keys.at(event.key.code) = false;
-                keysReleased.at(event.key.code) = true;
-                break;
-            }
-            case sf::Event::MouseButtonPressed:
-            {
-                buttons.at(event.key.code) = true;
-                buttonsPressed.at(event.mouseButton.button) = true;
-                break;
-            }
-            case sf::Event::MouseButtonReleased:
-            {
-                buttons.at(event.key.code) = false;
-                buttonsReleased.at(event.mouseButton.button) = true;
-                break;
-            }
-            case sf::Event::MouseMoved:
-            {
-                mousePos.x = event.mouseMove.x;
-                mousePos.y = event.mouseMove.y;
-                break;
-            }
-            case sf::Event::MouseWheelScrolled:
-            {
-                scrollWheel += event.mouseWheelScroll.delta;
-                break;
-            }
-            case sf::Event::TextEntered:
-            {
-                text = text + static_cast<char>(event.text.unicode);
-            }
-        }
+        std::scoped_lock lock(muxWaiters);
+        waiters.push_back({waiter, std::move(resume)});
+        hasWaiters.store(true, std::memory_order_seq_cst);
     }
 
-    void _setup()
+    // a waiter that is going away takes its resume out, so it is never called after that
+    void cancel_wait(const void* waiter)
     {
-        if(hasSetup) return;
-        hasSetup = true;
+        std::scoped_lock lock(muxWaiters);
+        waiters.erase(std::remove_if(waiters.begin(), waiters.end(), [waiter](const Waiter &w) { return w.waiter == waiter; }), waiters.end());
+        hasWaiters.store(!waiters.empty(), std::memory_order_relaxed);
+    }
 
-        for(int i = 0; i < Key::KeyCount; i++)
-        {
-            keys.insert({i, false});
-            keysPressed.insert({i, false});
-            keysReleased.insert({i, false});
-        }
+    bool has_space()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        return cells[pos & mask].sequence.load(std::memory_order_acquire) == pos;
+    }
 
-        for(int i = 0; i < MouseButton::ButtonCount; i++)
+    // sleeps until something is pushed, producers only touch the mutex while the consumer is asleep
+    void wait()
+    {
+        while(empty())
         {
-            buttons.insert({i, false});
-            buttonsPressed.insert({i, false});
-            buttonsPressed.insert({i, false});
+            sleeping.store(true, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::unique_lock<std::mutex> ul(muxBlocking);
+            blocking.wait(ul, [this]() { return !empty(); });
+            sleeping.store(false, std::memory_order_relaxed);
         }
     }
 
 private:
-    std::map<int, bool> keys;
-    std::map<int, bool> keysPressed;
-    std::map<int, bool> keysReleased;
-    std::map<int, bool> buttons;
-    std::map<int, bool> buttonsPressed;
-    std::map<int, bool> buttonsReleased;
-    Vector2 mousePos;
-    float scrollWheel;
-    bool hasSetup = false;
-    std::string text;
-};
-
-class Audio
-{
-public:
-    Audio() {}
-
-    bool AddSound(std::string name, std::string filepath)
+    void wake()
     {
-        if(sounds.count(name) != 0) return false;
-        sf::SoundBuffer buffer;
-        if(!buffer.loadFromFile(filepath)) return false;
-        sounds.insert({name, buffer});
-        return true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(sleeping.load(std::memory_order_relaxed))
+        {
+            std::unique_lock<std::mutex> ul(muxBlocking);
+            blocking.notify_one();
+        }
     }
 
-    bool RemoveSound(std::string name)
+    // producers only touch the mutex while one of them is waiting for space
+    void resumeWaiters()
     {
-        if(sounds.count(name) == 0) return false;
-        sounds.erase(name);
-        return true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(!hasWaiters.load(std::memory_order_relaxed)) return;
+        std::scoped_lock lock(muxWaiters);
+        for(Waiter &w : waiters)
+        {
+            w.resume();
+        }
+        waiters.clear();
+        hasWaiters.store(false, std::memory_order_relaxed);
     }
 
-    void RemoveAllSounds()
+    struct Cell
     {
-        sounds.clear();
-    }
+        std::atomic<size_t> sequence;
+        T value;
+    };
 
-    bool PlaySound(std::string name, float volume = 100.f, bool loop = false)
+    struct Waiter
     {
-        if(playing.count(name) != 0) return false;
-        playing.insert({name, {}});
-        playing.at(name).setBuffer(sounds.at(name));
-        playing.at(name).setVolume(volume);
-        playing.at(name).setLoop(loop);
-        playing.at(name).play();
-        return true;
-    }
+        const void* waiter;
+        std::function<void()> resume;
+    };
 
-    bool PauseSound(std::string name)
+    std::unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+    // kept on separate cache lines so producers and the consumer don't fight over them
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> dequeuePos{0};
+    std::atomic<bool> sleeping{false};
+    std::condition_variable blocking;
+    std::mutex muxBlocking;
+    std::atomic<bool> hasWaiters{false};
+    std::vector<Waiter> waiters;
+    std::mutex muxWaiters;
+};
+
+// ids are a slot index in the low 16 bits and the slot's generation in the high 16, so adding, finding and removing are
+// all O(1) and an id that was removed never finds whatever reuses its slot. 0 is never handed out
+template <typename V>
+class SlotMap
+{
+public:
+    static constexpr uint32_t indexBits = 16;
+    static constexpr uint32_t indexMask = (1u << indexBits) - 1;
+
+    // returns 0 once every slot is taken
+    uint32_t insert(V value)
     {
-        if(playing.count(name) != 0) return false;
-        playing.at(name).pause();
-        return true;
+        uint32_t index;
+        if(!freeSlots.empty())
+        {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            if(slots.size() > indexMask) return 0;
+            index = slots.size();
+            slots.push_back({});
+        }
+        Slot& slot = slots[index];
+        slot.dense = values.size();
+        uint32_t id = (uint32_t(slot.generation) << indexBits) | index;
+        values.push_back(std::move(value));
+        denseIDs.push_back(id);
+        return id;
     }
 
-    bool StopSound(std::string name)
+    V* find(uint32_t id)
     {
-        if(playing.count(name) == 0) return false;
-        playing.at(name).stop();
-        playing.erase(name);
-        return true;
+        uint32_t index = id & indexMask;
+        if(index >= slots.size()) return nullptr;
+        Slot& slot = slots[index];
+        if(slot.dense == empty || slot.generation != (id >> indexBits)) return nullptr;
+        return &values[slot.dense];
     }
 
-    void StopAllSounds()
+    // the last value moves into the hole, so the values stay packed
+    bool erase(uint32_t id)
     {
-        std::map<std::string, sf::Sound>::iterator it = playing.begin();
-        while(it != playing.end())
+        if(find(id) == nullptr) return false;
+        uint32_t index = id & indexMask;
+        Slot& slot = slots[index];
+        uint32_t last = values.size() - 1;
+        if(slot.dense != last)
         {
-            playing.at(it->first).stop();
+            values[slot.dense] = std::move(values[last]);
+            denseIDs[slot.dense] = denseIDs[last];
+            slots[denseIDs[last] & indexMask].dense = slot.dense;
         }
-        playing.clear();
-    }
-
-    bool AddMusic(std::string name, std::string filepath)
-    {
-        if(musicFiles.count(name) != 0) return false;
-        musicFiles.insert({name, filepath});
+        values.pop_back();
+        denseIDs.pop_back();
+        slot.dense = empty;
+        slot.generation = slot.generation == 0xFFFF ? 1 : slot.generation + 1;
+        freeSlots.push_back(index);
         return true;
     }
 
-    bool RemoveMusic(std::string name)
+    size_t size() const
     {
-        if(musicFiles.count(name) == 0) return false;
-        musicFiles.erase(name);
-        return true;
+        return values.size();
     }
 
-    void RemoveAllMusic()
+    // every value, packed together in no particular order
+    std::vector<V>& items()
     {
-        musicFiles.clear();
+        return values;
     }
 
-    bool PlayMusic(std::string name, float volume = 100.f, bool loop = true)
+    uint32_t idAt(size_t dense) const
     {
-        music.stop();
-        if(musicFiles.count(name) == 0) return false;
-        if(!music.openFromFile(musicFiles.at(name))) return false;
-        music.setVolume(volume);
-        music.setLoop(loop);
-        music.play();
+        return denseIDs[dense];
     }
 
 private:
-    std::map<std::string, sf::SoundBuffer> sounds;
-    std::map<std::string, sf::Sound> playing;
-    std::map<std::string, std::string> musicFiles;
-    sf::Music music;
-    sf::SoundBuffer buffer;
-};
+    static constexpr uint32_t empty = 0xFFFFFFFF;
 
-class Transform;
-class Application;
+    struct Slot
+    {
+        uint32_t dense = empty;
+        uint16_t generation = 1;
+    };
 
-class Script
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::vector<V> values;
+    std::vector<uint32_t> denseIDs;
+};
+
+template <typename T>
+class Connection : public std::enable_shared_from_this<Connection<T>>
 {
 public:
-    Script() {}
-
-    virtual void Start()
+    enum class owner { server, client };
+    // message reads each header then each body, buffered reads whatever has arrived and splits it into messages
+    enum class readMode { message, buffered };
+    // reliable goes over tcp, unreliable goes in a datagram that may be lost or reordered, sequenced also drops
+    // anything older than the newest message received with the same id
+    enum class channel { reliable, unreliable, sequenced };
+    
+    Connection(owner parent, asio::io_context &asioContext, asio::ip::tcp::socket socket, MpscQueue<OwnedMessage<T>> &qIn)
+    : m_socket(std::move(socket)), m_asioContext(asioContext), m_strand(asio::make_strand(asioContext)), m_qMessagesIn(qIn)
     {
-
+        m_ownerType = parent;
+        if(m_ownerType == owner::server)
+        {
+            m_handshakeOut = uint64_t(std::chrono::system_clock::now().time_since_epoch().count());
+            m_handshakeCheck = scramble(m_handshakeOut);
+            // the handshake is predictable and sent in the clear, so datagrams get a token of their own
+            std::random_device random;
+            std::mt19937_64 generator((uint64_t(random()) << 32) | random());
+            m_datagramToken = generator();
+            std::error_code ec;
+            m_remoteAddress = m_socket.remote_endpoint(ec).address();
+        }
+        else
+        {
+            m_handshakeIn = 0;
+            m_handshakeOut = 0;
+        }
     }
 
-    virtual void Update()
+    virtual ~Connection()
     {
-
+        m_qMessagesIn.cancel_wait(this);
     }
-
-    virtual void LateUpdate()
+    
+    uint32_t getID() const
     {
-
+        return id;
     }
 
-    virtual void OnCreate()
+    // random per connection and sent to the client once it is validated, it ties datagrams to the connection
+    uint64_t getToken() const
     {
-
+        return m_datagramToken;
     }
 
-    virtual void OnDestroy()
+    // where the client connected from, only set on the server
+    const asio::ip::address &getRemoteAddress() const
     {
-
+        return m_remoteAddress;
     }
 
-    void _setup(sf::View* camera, Time* time, Math* math, Input* input, Audio* audio)
+    // called on the io thread once a client connection has answered the handshake
+    void setValidatedCallback(std::function<void()> callback)
     {
-        this->camera = camera;
-        this->time = time;
-        this->math = math;
-        this->input = input;
-        this->audio = audio;
+        m_onValidated = std::move(callback);
     }
-
-    GameObject* self;
-    template <class T>
-    T* GetComponent()
+    
+    void connectToClient(server_interface<T>* server, uint32_t uid = 0)
     {
-        return self->template GetComponent<T>();
+        if(m_ownerType == owner::server)
+        {
+            if(m_socket.is_open())
+            {
+                id = uid;
+                asio::post(m_strand, [this, server]()
+                {
+                    writeValidation();
+                    readValidation(server);
+                });
+            }
+        }
     }
 
-    template <class T>
-    bool HasComponent()
+    bool connectToServer(const asio::ip::tcp::resolver::results_type &endpoints)
     {
-        return self->template HasComponent<T>();
-    }
-
-    Application* app;
-    sf::View* camera;
-    Transform* transform;
+        if(m_ownerType == owner::client)
+        {
+            asio::async_connect(m_socket, endpoints, asio::bind_executor(m_strand, [this](std::error_code ec, asio::ip::tcp::endpoint endpoint)
+            {
+                if(!ec)
+                {
+                    readValidation();
+                }
+            }));
+            return true;
+        }
+        return false;
+    }
+
+    bool disconnect()
+    {
+        if(isConnected()) asio::post(m_strand, [this]()
+        {
+            m_socket.close();
+        });
+        return true;
+    }
+
+    bool isConnected() const
+    {
+        return m_socket.is_open();
+    }
+
+    bool send(const Message<T> &msg)
+    {
+        return send(std::make_shared<const Message<T>>(msg));
+    }
+
+    bool send(SharedMessage<T> msg)
+    {
+        asio::post(m_strand, [this, msg = std::move(msg)]() mutable
+        {
+            bool writingMessage = !m_qMessagesOut.empty();
+            m_qMessagesOut.push_back(std::move(msg));
+            if(!writingMessage) writeMessages();
+        });
+        return true;
+    }
+
+    // the most bytes of queued messages gathered into one write, a larger message is still sent on its own
+    void setWriteBudget(size_t bytes)
+    {
+        asio::post(m_strand, [this, bytes]()
+        {
+            m_writeBudget = bytes;
+        });
+    }
+
+    asio::ip::tcp::socket* getSocket()
+    {
+        return &m_socket;
+    }
+
+    // only read when the connection is validated
+    void setReadMode(readMode mode)
+    {
+        m_readMode = mode;
+    }
+
+private:
+    void startReading()
+    {
+        if(m_readMode == readMode::buffered) readBuffered();
+        else readHeader();
+    }
+
+    void readBuffered()
+    {
+        m_socket.async_read_some(asio::buffer(m_readBuffer.data() + m_readEnd, m_readBuffer.size() - m_readEnd), asio::bind_executor(m_strand, [this](std::error_code ec, std::size_t length)
+        {
+            if(!ec)
+            {
+                m_readEnd += length;
+                processBuffered();
+            }
+            else
+            {
+                std::cout << "[" << id << "] Read Fail.\n";
+                m_socket.close();
+            }
+        }));
+    }
+
+    void processBuffered()
+    {
+        if(!frameMessages())
+        {
+            std::cout << "[" << id << "] Invalid Message.\n";
+            m_socket.close();
+        }
+        else if(m_readPaused) waitForQueue();
+        else readBuffered();
+    }
+
+    // the incoming queue was full, so this connection stops reading until the game thread has made room, rather than
+    // the io thread spinning and stalling every other connection with it
+    void waitForQueue()
+    {
+        m_readPaused = true;
+        std::function<void()> resume;
+        if(m_ownerType == owner::server)
+        {
+            // a weak pointer, so a connection that is dropped while it waits isn't kept alive by the queue
+            std::weak_ptr<Connection<T>> weak = this->weak_from_this();
+            resume = [this, weak]() { asio::post(m_strand, [weak]() { if(auto self = weak.lock()) self->resumeReading(); }); };
+        }
+        else resume = [this]() { asio::post(m_strand, [this]() { resumeReading(); }); };
+        m_qMessagesIn.wait_for_space(this, resume);
+        if(m_qMessagesIn.has_space()) resume();
+    }
+
+    // runs on the strand once the queue has room, it can be woken more than once for the same wait
+    void resumeReading()
+    {
+        if(!m_readPaused) return;
+        if(!m_socket.is_open())
+        {
+            m_blockedIn = {};
+            m_readPaused = false;
+            return;
+        }
+        if(!pushBlocked())
+        {
+            waitForQueue();
+            return;
+        }
+        m_readPaused = false;
+        if(m_readMode == readMode::buffered) processBuffered();
+        else readHeader();
+    }
+
+    // queues every complete message in the read buffer, stopping early with m_readPaused set if the queue fills up,
+    // false if a header makes no sense
+    bool frameMessages()
+    {
+        while(m_readEnd - m_readStart >= sizeof(MessageHeader<T>))
+        {
+            MessageHeader<T> header;
+            std::memcpy(&header, m_readBuffer.data() + m_readStart, sizeof(MessageHeader<T>));
+            size_t total = header.size == 0 ? sizeof(MessageHeader<T>) : header.size;
+            if(total < sizeof(MessageHeader<T>)) return false;
+            if(m_readEnd - m_readStart < total)
+            {
+                if(total > m_readBuffer.size()) m_readBuffer.resize(total);
+                break;
+            }
+            Message<T> msg;
+            msg.header = header;
+            const uint8_t* body = m_readBuffer.data() + m_readStart + sizeof(MessageHeader<T>);
+            msg.reserve(total - sizeof(MessageHeader<T>));
+            msg.body.assign(body, body + (total - sizeof(MessageHeader<T>)));
+            m_readStart += total;
+            if(!addToIncomingMessageQueue(std::move(msg)))
+            {
+                m_readPaused = true;
+                break;
+            }
+        }
+        // whatever is left is the start of a message, move it to the front so the rest has room to arrive
+        if(m_readStart > 0)
+        {
+            std::memmove(m_readBuffer.data(), m_readBuffer.data() + m_readStart, m_readEnd - m_readStart);
+            m_readEnd -= m_readStart;
+            m_readStart = 0;
+        }
+        return true;
+    }
+
+    void readHeader()
+    {
+        asio::async_read(m_socket, asio::buffer(&m_msgTemporaryIn.header, sizeof(MessageHeader<T>)), asio::bind_executor(m_strand, [this](std::error_code ec, std::size_t)
+        {
+            if(!ec)
+            {
+                if(m_msgTemporaryIn.header.size > 0)
+                {
+                    m_msgTemporaryIn.reserve(m_msgTemporaryIn.header.size - sizeof(MessageHeader<T>));
+                    m_msgTemporaryIn.body.resize(m_msgTemporaryIn.header.size - sizeof(MessageHeader<T>));
+                    readBody();
+                }
+                else if(addToIncomingMessageQueue(std::move(m_msgTemporaryIn))) readHeader();
+                else waitForQueue();
+            }
+            else
+            {
+                std::cout << "[" << id << "] Read Header Fail.\n";
+                m_socket.close();
+            }
+        }));
+    }
+    
+    void readBody()
+    {
+        asio::async_read(m_socket, asio::buffer(m_msgTemporaryIn.body.data(), m_msgTemporaryIn.body.size()), asio::bind_executor(m_strand, [this](std::error_code ec, std::size_t)
+        {
+            if(!ec)
+            {
+                if(addToIncomingMessageQueue(std::move(m_msgTemporaryIn))) readHeader();
+                else waitForQueue();
+            }
+            else
+            {
+                std::cout << "[" << id << "] Read Body Fail.\n";
+                m_socket.close();
+            }
+        }));
+    }
+
+    // sends as many queued messages as fit in the write budget with a single async_write
+    void writeMessages()
+    {
+        // small messages are copied next to each other so a run of them is one buffer, larger bodies are sent from the message
+        m_writeStaging.clear();
+        if(m_writeStaging.capacity() < m_writeBudget + sizeof(MessageHeader<T>) + smallBodySize) m_writeStaging.reserve(m_writeBudget + sizeof(MessageHeader<T>) + smallBodySize);
+        m_writeBuffers.clear();
+        m_writeCount = 0;
+        size_t bytes = 0, runStart = 0;
+        size_t queued = m_qMessagesOut.count();
+        while(m_writeCount < queued)
+        {
+            const Message<T> &msg = *m_qMessagesOut.at(m_writeCount);
+            if(m_writeCount > 0 && bytes + msg.size() > m_writeBudget) break;
+            const uint8_t* header = (const uint8_t*)&msg.header;
+            m_writeStaging.insert(m_writeStaging.end(), header, header + sizeof(MessageHeader<T>));
+            if(msg.body.size() <= smallBodySize)
+            {
+                m_writeStaging.insert(m_writeStaging.end(), msg.body.begin(), msg.body.end());
+            }
+            else
+            {
+                m_writeBuffers.push_back(asio::buffer(m_writeStaging.data() + runStart, m_writeStaging.size() - runStart));
+                m_writeBuffers.push_back(asio::buffer(msg.body.data(), msg.body.size()));
+                runStart = m_writeStaging.size();
+            }
+            bytes += msg.size();
+            m_writeCount++;
+        }
+        if(runStart < m_writeStaging.size()) m_writeBuffers.push_back(asio::buffer(m_writeStaging.data() + runStart, m_writeStaging.size() - runStart));
+
+        asio::async_write(m_socket, m_writeBuffers, asio::bind_executor(m_strand, [this](std::error_code ec, std::size_t)
+        {
+            if(!ec)
+            {
+                for(size_t i = 0; i < m_writeCount; i++)
+                {
+                    m_qMessagesOut.pop_front();
+                }
+                if(!m_qMessagesOut.empty())
+                {
+                    writeMessages();
+                }
+            }
+            else
+            {
+                std::cout << "[" << id << "] Write Fail.\n";
+                m_socket.close();
+            }
+        }));
+    }
+
+    // false if the queue is full, the message is then kept in m_blockedIn for waitForQueue
+    bool addToIncomingMessageQueue(Message<T> &&msg)
+    {
+        m_blockedIn.msg = std::move(msg);
+        return pushBlocked();
+    }
+
+    // the message only points at the connection while it is in the queue, one left waiting would keep the connection alive
+    bool pushBlocked()
+    {
+        if(m_ownerType == owner::server) m_blockedIn.remote = this->shared_from_this();
+        if(m_qMessagesIn.try_push(std::move(m_blockedIn))) return true;
+        m_blockedIn.remote = nullptr;
+        return false;
+    }
+    
+    uint64_t scramble(uint64_t input)
+    {
+        uint64_t out; input &= input >> 1; out = input ^ (input << 16) + 63512465; out *= out * 3; out += input << 16; out /= input; out++; out &= input ^ (input * (out ^ input)); out ^= 76225362; out ^= 0x01574185AB54; return out >> 16;
+    }
+
+    void writeValidation()
+    {
+        asio::async_write(m_socket, asio::buffer(&m_handshakeOut, sizeof(uint64_t)), asio::bind_executor(m_strand, [this](std::error_code ec, std::size_t)
+        {
+            if(!ec)
+            {
+                if(m_ownerType == owner::client) readDatagramToken();
+            }
+            else
+            {
+                m_socket.close();
+            }
+        }));
+    }
+
+    void readValidation(server_interface<T>* server = nullptr)
+    {
+        asio::async_read(m_socket, asio::buffer(&m_handshakeIn, sizeof(uint64_t)), asio::bind_executor(m_strand, [this, server](std::error_code ec, std::size_t)
+        {
+            if(!ec)
+            {
+                if(m_ownerType == owner::server)
+                {
+                    if(m_handshakeIn == m_handshakeCheck)
+                    {
+                        std::cout << "Client Validated" << std::endl;
+                        writeDatagramToken(server);
+                    }
+                    else
+                    {
+                        std::cout << "Client Disconnected (Fail Validation)" << std::endl;
+                        m_socket.close();
+                    }
+                }
+                else
+                {
+                    m_handshakeOut = scramble(m_handshakeIn);
+                    writeValidation();
+                }
+            }
+            else
+            {
+                std::cout << "Client Disconnected (readValidation)" << std::endl;
+                m_socket.close();
+            }
+        }));
+    }
+    // the token goes before any message, so nothing the server sends once the client is validated can get ahead of it
+    void writeDatagramToken(server_interface<T>* server)
+    {
+        asio::async_write(m_socket, asio::buffer(&m_datagramToken, sizeof(uint64_t)), asio::bind_executor(m_strand, [this, server](std::error_code ec, std::size_t)
+        {
+            if(!ec)
+            {
+                server->validateClient(this->shared_from_this());
+                startReading();
+            }
+            else
+            {
+                m_socket.close();
+            }
+        }));
+    }
+
+    void readDatagramToken()
+    {
+        asio::async_read(m_socket, asio::buffer(&m_datagramToken, sizeof(uint64_t)), asio::bind_executor(m_strand, [this](std::error_code ec, std::size_t)
+        {
+            if(!ec)
+            {
+                if(m_onValidated) m_onValidated();
+                startReading();
+            }
+            else
+            {
+                std::cout << "Client Disconnected (readDatagramToken)" << std::endl;
+                m_socket.close();
+            }
+        }));
+    }
+protected:
+    asio::ip::tcp::socket m_socket;
+    asio::io_context& m_asioContext;
+    // every handler for this connection runs through the strand, so they never overlap even with several io threads
+    asio::strand<asio::io_context::executor_type> m_strand;
+    TsQueue<SharedMessage<T>> m_qMessagesOut;
+    MpscQueue<OwnedMessage<T>>& m_qMessagesIn;
+    Message<T> m_msgTemporaryIn;
+    owner m_ownerType = owner::server;
+    uint32_t id = 0;
+    uint64_t m_handshakeOut = 0;
+    uint64_t m_handshakeIn = 0;
+    uint64_t m_handshakeCheck = 0;
+    uint64_t m_datagramToken = 0;
+    asio::ip::address m_remoteAddress;
+    // bodies up to this size are copied into the staging buffer rather than given a buffer of their own
+    static constexpr size_t smallBodySize = 256;
+    size_t m_writeBudget = 64 * 1024;
+    std::vector<uint8_t> m_writeStaging;
+    std::vector<asio::const_buffer> m_writeBuffers;
+    size_t m_writeCount = 0;
+    readMode m_readMode = readMode::buffered;
+    // grows to fit the largest message, m_readStart to m_readEnd is what has arrived but not been framed yet
+    std::vector<uint8_t> m_readBuffer = std::vector<uint8_t>(64 * 1024);
+    // the message that didn't fit in the incoming queue, reading waits until the queue's consumer makes room
+    OwnedMessage<T> m_blockedIn;
+    bool m_readPaused = false;
+    size_t m_readStart = 0, m_readEnd = 0;
+    std::function<void()> m_onValidated;
+};
+
+template<typename T>
+class client_interface
+{
+public:
+    client_interface() : m_socket(m_context), m_udpSocket(m_context), m_registerTimer(m_context) {}
+    
+    virtual ~client_interface()
+    {
+        disconnect();
+    }
+    
+    bool connect(const std::string &host, const uint16_t port)
+    {
+        try
+        {
+            asio::ip::tcp::resolver resolver(m_context);
+            asio::ip::tcp::resolver::results_type endpoints = resolver.resolve(host, std::to_string(port));
+            m_connection = std::make_unique<Connection<T>>(Connection<T>::owner::client, m_context, asio::ip::tcp::socket(m_context), m_qMessagesIn);
+            m_connection->setReadMode(m_readMode);
+            if(usesDatagrams())
+            {
+                asio::ip::udp::resolver udpResolver(m_context);
+                m_udpSocket.connect(*udpResolver.resolve(asio::ip::udp::v4(), host, std::to_string(port)).begin());
+                m_connection->setValidatedCallback([this]()
+                {
+                    m_registerAttempts = 0;
+                    registerDatagrams();
+                });
+                readDatagram();
+            }
+            m_connection->connectToServer(endpoints);
+            thrContext  = std::thread([this]() { m_context.run(); });
+        }
+        catch (std::exception e)
+        {
+            std::cerr << "Client Exception: " << e.what() << "\n";
+            return false;
+        }
+        return true;
+    }
+    
+    void disconnect()
+    {
+        if(isConnected())
+        {
+            m_connection->disconnect();
+        }
+        m_context.stop();
+        if(thrContext.joinable()) thrContext.join();
+        m_connection.release();
+    }
+    
+    bool isConnected()
+    {
+        if(m_connection)
+        return m_connection->isConnected();
+        return false;
+    }
+    
+    bool sendMessage(const Message<T> &msg)
+    {
+        return sendMessage(std::make_shared<const Message<T>>(msg));
+    }
+
+    // goes on the channel set for the message's id, datagrams fall back to tcp until the server has answered registerDatagrams
+    bool sendMessage(SharedMessage<T> msg)
+    {
+        if(m_udpSocket.is_open() && channelOf(msg->header.id) != Connection<T>::channel::reliable && Datagram<T>::fits(*msg))
+        {
+            asio::post(m_context, [this, msg = std::move(msg)]()
+            {
+                if(!m_datagramsReady)
+                {
+                    m_connection->send(msg);
+                    return;
+                }
+                Datagram<T>::write(m_datagramOut, m_connection->getToken(), m_server.nextSequence++, *msg);
+                std::error_code ec;
+                m_udpSocket.send(asio::buffer(m_datagramOut), 0, ec);
+            });
+            return true;
+        }
+        m_connection->send(std::move(msg));
+        return true;
+    }
+
+    MpscQueue<OwnedMessage<T>>& incoming()
+    {
+        return m_qMessagesIn;
+    }
+
+    // call before connect
+    void setReadMode(typename Connection<T>::readMode mode)
+    {
+        m_readMode = mode;
+    }
+
+    // how messages with this id are sent, set the same channels on the server, call before connect
+    void setChannel(T id, typename Connection<T>::channel channel)
+    {
+        m_channels[uint32_t(id)] = channel;
+    }
+    
+protected:
+    asio::io_context m_context;
+    std::thread thrContext;
+    asio::ip::tcp::socket m_socket;
+    std::unique_ptr<Connection<T>> m_connection;
+    typename Connection<T>::readMode m_readMode = Connection<T>::readMode::buffered;
+    asio::ip::udp::socket m_udpSocket;
+
+private:
+    typename Connection<T>::channel channelOf(T id)
+    {
+        auto it = m_channels.find(uint32_t(id));
+        return it == m_channels.end() ? Connection<T>::channel::reliable : it->second;
+    }
+
+    bool usesDatagrams()
+    {
+        for(auto &channel : m_channels)
+        {
+            if(channel.second != Connection<T>::channel::reliable) return true;
+        }
+        return false;
+    }
+
+    // sent again until the server answers, the first can arrive before the server has read the handshake that
+    // tells it the token. a server that never answers leaves everything on tcp
+    void registerDatagrams()
+    {
+        if(m_datagramsReady || !isConnected() || m_registerAttempts >= maxRegisterAttempts) return;
+        m_registerAttempts++;
+        Datagram<T>::writeToken(m_datagramOut, m_connection->getToken());
+        std::error_code ec;
+        m_udpSocket.send(asio::buffer(m_datagramOut), 0, ec);
+        m_registerTimer.expires_after(std::chrono::milliseconds(200));
+        m_registerTimer.async_wait([this](std::error_code ec)
+        {
+            if(!ec) registerDatagrams();
+        });
+    }
+
+    void readDatagram()
+    {
+        m_udpSocket.async_receive(asio::buffer(m_datagramIn), [this](std::error_code ec, std::size_t length)
+        {
+            if(ec == asio::error::operation_aborted) return;
+            uint64_t token;
+            uint32_t sequence;
+            Message<T> msg;
+            if(!ec && Datagram<T>::readToken(m_datagramIn.data(), length, token) && token == m_connection->getToken())
+            {
+                // just the token is the server answering registerDatagrams
+                if(length == sizeof(uint64_t))
+                {
+                    m_datagramsReady = true;
+                    m_registerTimer.cancel();
+                }
+                else if(m_datagramsReady && Datagram<T>::read(m_datagramIn.data(), length, sequence, msg))
+                {
+                    // datagrams can be lost anyway, so one that doesn't fit in a full queue is dropped rather than waited on
+                    if(channelOf(msg.header.id) != Connection<T>::channel::sequenced || m_server.isNewest(msg.header.id, sequence))
+                    {
+                        m_qMessagesIn.try_push({nullptr, std::move(msg)});
+                    }
+                }
+            }
+            readDatagram();
+        });
+    }
+
+    MpscQueue<OwnedMessage<T>> m_qMessagesIn;
+    std::unordered_map<uint32_t, typename Connection<T>::channel> m_channels;
+    // only touched on the io thread
+    DatagramPeer<T> m_server;
+    bool m_datagramsReady = false;
+    asio::steady_timer m_registerTimer;
+    int m_registerAttempts = 0;
+    // 200ms apart
+    static constexpr int maxRegisterAttempts = 25;
+    std::vector<uint8_t> m_datagramIn = std::vector<uint8_t>(64 * 1024);
+    std::vector<uint8_t> m_datagramOut;
+};
+
+template <typename T>
+class server_interface
+{
+public:
+    server_interface(uint16_t port) : m_asioAcceptor(m_asioContext, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port)), m_udpSocket(m_asioContext), m_udpStrand(asio::make_strand(m_asioContext)), m_port(port) {}
+    
+    virtual ~server_interface()
+    {
+        stop();
+        // queued messages own their connections, which have to go while the context their strands use is still alive
+        m_qMessagesIn.clear();
+    }
+    
+    bool start()
+    {
+        try
+        {
+            waitForClientConnection();
+            if(usesDatagrams())
+            {
+                m_udpSocket.open(asio::ip::udp::v4());
+                m_udpSocket.bind(asio::ip::udp::endpoint(asio::ip::udp::v4(), m_port));
+                readDatagram();
+            }
+            size_t threads = m_threadCount > 0 ? m_threadCount : std::max(1u, std::thread::hardware_concurrency());
+            for(size_t i = 0; i < threads; i++)
+            {
+                m_threads.emplace_back([this]()
+                {
+                    m_asioContext.run();
+                });
+            }
+        }
+        catch (std::exception e)
+        {
+            std::cerr << "[SERVER] Exception: " << e.what() << "\n";
+            return false;
+        }
+        std::cout << "[SERVER] Started\n";
+        return true;
+    }
+    
+    void stop()
+    {
+        m_asioContext.stop();
+        for(std::thread& thread : m_threads)
+        {
+            if(thread.joinable()) thread.join();
+        }
+        m_threads.clear();
+        std::cout << "[SERVER] Stopped\n";
+    }
+
+    void waitForClientConnection()
+    {
+        m_asioAcceptor.async_accept([this](std::error_code ec, asio::ip::tcp::socket socket)
+        {
+            if(!ec)
+            {
+                std::cout << "[SERVER] New Connection: " << socket.remote_endpoint() << "\n";
+                std::shared_ptr<Connection<T>> newconn = std::make_shared<Connection<T>>(Connection<T>::owner::server, m_asioContext, std::move(socket), m_qMessagesIn);
+                std::scoped_lock lock(m_muxConnections);
+                if(m_connections.size() <= m_connections.indexMask && this->onClientConnect(newconn))
+                {
+                    newconn->setReadMode(m_readMode);
+                    uint32_t id = m_connections.insert(newconn);
+                    newconn->connectToClient(this, id);
+                    std::cout << "[" << id << "] Connection Approved\n";
+                }
+                else
+                {
+                    std::cout << "[-----] Connection Denied\n";
+                }
+            }
+            else
+            {
+                std::cout << "[SERVER] New Connection Error: " << ec.message() << "\n";
+            }
+            waitForClientConnection();
+        });
+    }
+
+    void messageClient(std::shared_ptr<Connection<T>> client, const Message<T> &msg)
+    {
+        messageClient(std::move(client), std::make_shared<const Message<T>>(msg));
+    }
+
+    void messageClient(std::shared_ptr<Connection<T>> client, SharedMessage<T> msg)
+    {
+        if(!client) return;
+        std::scoped_lock lock(m_muxConnections);
+        if(client->isConnected())
+        {
+            deliver(client, msg);
+        }
+        else
+        {
+            removeClient(client);
+        }
+    }
+
+    void messageClient(uint32_t id, const Message<T> &msg)
+    {
+        messageClient(getClient(id), msg);
+    }
+
+    void messageClient(uint32_t id, SharedMessage<T> msg)
+    {
+        messageClient(getClient(id), std::move(msg));
+    }
+
+    // nullptr once the client has been removed, even if a new client has been given the same slot
+    std::shared_ptr<Connection<T>> getClient(uint32_t id)
+    {
+        std::scoped_lock lock(m_muxConnections);
+        std::shared_ptr<Connection<T>>* client = m_connections.find(id);
+        return client != nullptr ? *client : nullptr;
+    }
+
+    // the message is copied once and every client queues the same copy
+    void messageAllClients(const Message<T> &msg, std::shared_ptr<Connection<T>> ignoreClient = nullptr)
+    {
+        messageAllClients(std::make_shared<const Message<T>>(msg), std::move(ignoreClient));
+    }
+
+    void messageAllClients(const SharedMessage<T> &msg, std::shared_ptr<Connection<T>> ignoreClient = nullptr)
+    {
+        std::scoped_lock lock(m_muxConnections);
+        m_disconnected.clear();
+        for(auto &client : m_connections.items())
+        {
+            if(client->isConnected())
+            {
+                if(client != ignoreClient) deliver(client, msg);
+            }
+            else
+            {
+                m_disconnected.push_back(client);
+            }
+        }
+        removeDisconnected();
+    }
+
+    // the area of the world this client can see, for messageClientsInView. ignored once the client has been removed, so
+    // a late call doesn't leave a view behind that nothing will erase
+    void setClientView(std::shared_ptr<Connection<T>> client, const AABB &view)
+    {
+        std::scoped_lock lock(m_muxConnections);
+        std::shared_ptr<Connection<T>>* found = m_connections.find(client->getID());
+        if(found == nullptr || *found != client) return;
+        m_views[client->getID()].view = view;
+    }
+
+    // sends to the clients that source is relevant to, clients without a view get everything. like the Replicator, a source
+    // becomes relevant once position is inside the view and stops once it is further than the interest margin outside
+    void messageClientsInView(const Message<T> &msg, uint32_t source, Vector2 position)
+    {
+        SharedMessage<T> shared = std::make_shared<const Message<T>>(msg);
+        std::scoped_lock lock(m_muxConnections);
+        m_disconnected.clear();
+        for(auto &client : m_connections.items())
+        {
+            if(!client->isConnected())
+            {
+                m_disconnected.push_back(client);
+                continue;
+            }
+            auto view = m_views.find(client->getID());
+            if(view != m_views.end())
+            {
+                ClientView &state = view->second;
+                if(state.view.ContainsPoint(position)) state.relevant.insert(source);
+                else if(state.relevant.count(source) != 0)
+                {
+                    AABB outer(state.view.center, {state.view.halfDimension.x + m_interestMargin, state.view.halfDimension.y + m_interestMargin});
+                    if(!outer.ContainsPoint(position))
+                    {
+                        state.relevant.erase(source);
+                        continue;
+                    }
+                }
+                else continue;
+            }
+            deliver(client, shared);
+        }
+        removeDisconnected();
+    }
+
+    // call when a source passed to messageClientsInView is gone, so the clients stop remembering it
+    void forgetSource(uint32_t source)
+    {
+        std::scoped_lock lock(m_muxConnections);
+        for(auto &view : m_views)
+        {
+            view.second.relevant.erase(source);
+        }
+    }
+
+    // how far outside a client's view a source has to go before messageClientsInView stops sending it to them
+    void setInterestMargin(float margin)
+    {
+        std::scoped_lock lock(m_muxConnections);
+        m_interestMargin = margin;
+    }
+
+    // used for connections accepted after it is set
+    void setReadMode(typename Connection<T>::readMode mode)
+    {
+        m_readMode = mode;
+    }
+
+    // how messages with this id are sent, set the same channels on the clients, call before start
+    void setChannel(T id, typename Connection<T>::channel channel)
+    {
+        m_channels[uint32_t(id)] = channel;
+    }
+
+    // threads running the io context, 0 for one per core, only read when the server starts
+    // onClientConnect and onClientValidated can then run on several threads at once, onMessage still runs in update
+    void setThreadCount(size_t threads)
+    {
+        m_threadCount = threads;
+    }
+
+    void update(size_t maxMessages = -1, bool wait = false)
+    {
+        if(wait) m_qMessagesIn.wait();
+        // drain in one go then handle them, the vector is kept so its storage is reused
+        m_incoming.clear();
+        m_qMessagesIn.pop_all(m_incoming, maxMessages);
+        for(OwnedMessage<T>& msg : m_incoming)
+        {
+            this->onMessage(msg.remote, msg.msg);
+        }
+        m_incoming.clear();
+    }
+
+protected:
+    virtual bool onClientConnect(std::shared_ptr<Connection<T>> client)
+    {
+        return false;
+    }
+
+    virtual void onClientDisconnect(std::shared_ptr<Connection<T>> client) {}
+    
+    virtual void onMessage(std::shared_ptr<Connection<T>> client, Message<T> &msg) {}
+    
+public:
+    virtual void onClientValidated(std::shared_ptr<Connection<T>> client) {}
+
+    // called by the connection once the handshake checks out
+    void validateClient(std::shared_ptr<Connection<T>> client)
+    {
+        if(m_udpSocket.is_open())
+        {
+            asio::post(m_udpStrand, [this, client]()
+            {
+                DatagramPeer<T> &peer = m_datagramPeers[client->getToken()];
+                peer.connection = client;
+                peer.address = client->getRemoteAddress();
+            });
+        }
+        this->onClientValidated(client);
+    }
+    
+protected:
+    // connections unregister from the queue when they are destroyed, so it outlives the context and everything holding them
+    MpscQueue<OwnedMessage<T>> m_qMessagesIn;
+    asio::io_context m_asioContext;
+    std::vector<OwnedMessage<T>> m_incoming;
+    // by connection id
+    SlotMap<std::shared_ptr<Connection<T>>> m_connections;
+    std::vector<std::shared_ptr<Connection<T>>> m_disconnected;
+    std::vector<std::thread> m_threads;
+    size_t m_threadCount = 1;
+    asio::ip::tcp::acceptor m_asioAcceptor;
+    // guards m_connections and m_views, recursive so onClientDisconnect can message clients
+    std::recursive_mutex m_muxConnections;
+    typename Connection<T>::readMode m_readMode = Connection<T>::readMode::buffered;
+    asio::ip::udp::socket m_udpSocket;
+    // the datagram socket and m_datagramPeers are only used through this strand
+    asio::strand<asio::io_context::executor_type> m_udpStrand;
+    uint16_t m_port = 0;
+
+private:
+    typename Connection<T>::channel channelOf(T id)
+    {
+        auto it = m_channels.find(uint32_t(id));
+        return it == m_channels.end() ? Connection<T>::channel::reliable : it->second;
+    }
+
+    bool usesDatagrams()
+    {
+        for(auto &channel : m_channels)
+        {
+            if(channel.second != Connection<T>::channel::reliable) return true;
+        }
+        return false;
+    }
+
+    // sends on the channel set for the message's id, datagrams go over tcp until the client's address is known
+    void deliver(const std::shared_ptr<Connection<T>> &client, const SharedMessage<T> &msg)
+    {
+        if(!m_udpSocket.is_open() || channelOf(msg->header.id) == Connection<T>::channel::reliable || !Datagram<T>::fits(*msg))
+        {
+            client->send(msg);
+            return;
+        }
+        asio::post(m_udpStrand, [this, client, msg]()
+        {
+            auto peer = m_datagramPeers.find(client->getToken());
+            if(peer == m_datagramPeers.end() || !peer->second.hasEndpoint)
+            {
+                client->send(msg);
+                return;
+            }
+            Datagram<T>::write(m_datagramOut, peer->first, peer->second.nextSequence++, *msg);
+            std::error_code ec;
+            m_udpSocket.send_to(asio::buffer(m_datagramOut), peer->second.endpoint, 0, ec);
+        });
+    }
+
+    // removed after walking m_connections because removing moves other clients around in it. onClientDisconnect can
+    // message clients and get back into a walk, so the list is moved out first and only handed back once it's empty
+    void removeDisconnected()
+    {
+        std::vector<std::shared_ptr<Connection<T>>> disconnected;
+        disconnected.swap(m_disconnected);
+        for(auto &client : disconnected)
+        {
+            removeClient(client);
+        }
+        disconnected.clear();
+        if(m_disconnected.empty()) m_disconnected.swap(disconnected);
+    }
+
+    void removeClient(std::shared_ptr<Connection<T>> client)
+    {
+        // a client can turn up twice if a disconnect handler messaged it again
+        if(!m_connections.erase(client->getID())) return;
+        std::cout << "Removing ID: " << client->getID() << "\n";
+        this->onClientDisconnect(client);
+        forgetClient(client);
+    }
+
+    void forgetClient(const std::shared_ptr<Connection<T>> &client)
+    {
+        if(client) m_views.erase(client->getID());
+        if(client && m_udpSocket.is_open())
+        {
+            asio::post(m_udpStrand, [this, token = client->getToken()]()
+            {
+                m_datagramPeers.erase(token);
+            });
+        }
+    }
+
+    void readDatagram()
+    {
+        m_udpSocket.async_receive_from(asio::buffer(m_datagramIn), m_datagramSender, asio::bind_executor(m_udpStrand, [this](std::error_code ec, std::size_t length)
+        {
+            if(ec == asio::error::operation_aborted) return;
+            uint64_t token;
+            auto peer = m_datagramPeers.end();
+            if(!ec && Datagram<T>::readToken(m_datagramIn.data(), length, token)) peer = m_datagramPeers.find(token);
+            // the token alone isn't trusted, the datagram also has to come from the address the client connected from,
+            // and once registered from the same port
+            if(peer != m_datagramPeers.end() && (m_datagramSender.address() != peer->second.address || (peer->second.hasEndpoint && m_datagramSender != peer->second.endpoint)))
+            {
+                peer = m_datagramPeers.end();
+            }
+            uint32_t sequence;
+            Message<T> msg;
+            if(peer != m_datagramPeers.end() && length == sizeof(uint64_t))
+            {
+                // a client registering, answered with its token so it knows it can stop
+                peer->second.endpoint = m_datagramSender;
+                peer->second.hasEndpoint = true;
+                Datagram<T>::writeToken(m_datagramOut, token);
+                std::error_code sendError;
+                m_udpSocket.send_to(asio::buffer(m_datagramOut), m_datagramSender, 0, sendError);
+            }
+            else if(peer != m_datagramPeers.end() && peer->second.hasEndpoint && Datagram<T>::read(m_datagramIn.data(), length, sequence, msg))
+            {
+                // dropped if the queue is full, like any other lost datagram
+                if(channelOf(msg.header.id) != Connection<T>::channel::sequenced || peer->second.isNewest(msg.header.id, sequence))
+                {
+                    m_qMessagesIn.try_push({peer->second.connection, std::move(msg)});
+                }
+            }
+            readDatagram();
+        }));
+    }
+
+    struct ClientView
+    {
+        AABB view;
+        // the sources messageClientsInView is sending to this client
+        std::unordered_set<uint32_t> relevant;
+    };
+
+    std::unordered_map<uint32_t, typename Connection<T>::channel> m_channels;
+    std::unordered_map<uint64_t, DatagramPeer<T>> m_datagramPeers;
+    // by connection id, guarded by m_muxConnections
+    std::unordered_map<uint32_t, ClientView> m_views;
+    float m_interestMargin = 64.f;
+    asio::ip::udp::endpoint m_datagramSender;
+    std::vector<uint8_t> m_datagramIn = std::vector<uint8_t>(64 * 1024);
+    std::vector<uint8_t> m_datagramOut;
+};
+
+
+
+typedef std::string String;
+
+
+
+class File
+{
+public:
+    File() {}
+
+    File(std::vector<uint8_t> FileData)
+    {
+        this->data = FileData;
+    }
+
+    size_t Size() const
+    {
+        return data.size();
+    }
+
+    template <typename DataType>
+    friend File &operator << (File &f, const DataType &d)
+    {
+        static_assert(std::is_standard_layout<DataType>::value, "Data is too complex to be saved");
+        size_t i = f.data.size();
+        f.data.resize(f.data.size() + sizeof(DataType));
+        std::memcpy(f.data.data() + i, &d, sizeof(DataType));
+        return f;
+    }
+
+    template <typename DataType>
+    friend File &operator >> (File &f, DataType &d)
+    {
+        static_assert(std::is_standard_layout<DataType>::value, "Data is too complex to be loaded");
+        size_t i = f.data.size() - sizeof(DataType);
+        std::memcpy(&d, f.data.data() + i, sizeof(DataType));
+        f.data.resize(i);
+        return f;
+    }
+
+    std::vector<uint8_t>* Data()
+    {
+        return &data;
+    }
+
+    void Save(std::string FilePath)
+    {
+        std::ofstream out(FilePath, std::ios::out | std::ofstream::binary);
+        std::copy(data.begin(), data.end(), std::ostreambuf_iterator<char>(out));
+        out.close();
+    }
+
+    void Load(std::string FilePath)
+    {
+        std::vector<uint8_t> data;
+        std::ifstream in(FilePath, std::ios::in | std::ifstream::binary);
+        std::istreambuf_iterator<char> iter{in};
+        std::istreambuf_iterator<char> end{};
+        std::copy(iter, end, std::back_inserter(data));
+        in.close();
+        this->data = data;
+    }
+
+private:
+    std::vector<uint8_t> data;
+};
+
+class GameObject;
+
+// what the broad phase structures have in common, objects keep the proxy returned by add() to move or remove themselves
+class SpatialIndex
+{
+public:
+    static constexpr uint32_t NoProxy = 0xFFFFFFFF;
+
+    virtual ~SpatialIndex() {}
+
+    // returns NoProxy if the object can't be stored
+    virtual uint32_t add(GameObject* object, AABB bounds) = 0;
+    virtual void Update(uint32_t proxy, AABB bounds) = 0;
+    virtual void remove(uint32_t proxy) = 0;
+    // writes every object whose bounds intersect range into out, out is cleared first
+    virtual void queryRange(const AABB &range, std::vector<GameObject*> &out) = 0;
+    virtual void clear() = 0;
+    virtual size_t getCountAll() const = 0;
+};
+
+// nodes and items live in flat arrays linked by index, so clear() just resets them and rebuilding reuses the memory
+class QuadTree : public SpatialIndex
+{
+public:
+    QuadTree(AABB boundary, uint32_t nodeCapacity = 8, uint32_t maxDepth = 12)
+    {
+        this->boundary = boundary;
+        this->nodeCapacity = nodeCapacity;
+        this->maxDepth = maxDepth;
+        clear();
+    }
+
+    bool insert(GameObject* object, AABB bounds)
+    {
+        return add(object, bounds) != NoProxy;
+    }
+
+    // objects are stored in the smallest node that fully contains their bounds, the tree grows when one is centred outside it
+    uint32_t add(GameObject* object, AABB bounds) override
+    {
+        int32_t item;
+        if(!freeItems.empty())
+        {
+            item = freeItems.back();
+            freeItems.pop_back();
+        }
+        else
+        {
+            item = items.size();
+            items.push_back({});
+        }
+        items[item] = {object, bounds, -1, -1, -1};
+        place(item);
+        count++;
+        return item;
+    }
+
+    // the object stays in its node while it still fits there and can't go any deeper, otherwise it's placed again from the root
+    void Update(uint32_t proxy, AABB bounds) override
+    {
+        Item &item = items[proxy];
+        item.bounds = bounds;
+        bool fits = item.node == 0 ? boundary.ContainsPoint(bounds.center) : nodes[item.node].boundary.Contains(bounds);
+        if(fits && (nodes[item.node].children == -1 || childContaining(item.node, bounds) == -1)) return;
+        int32_t node = item.node;
+        unlink(proxy);
+        merge(node);
+        place(proxy);
+    }
+
+    void remove(uint32_t proxy) override
+    {
+        if(proxy >= items.size() || items[proxy].node == -1) return;
+        int32_t node = items[proxy].node;
+        unlink(proxy);
+        merge(node);
+        items[proxy].object = nullptr;
+        freeItems.push_back(proxy);
+        count--;
+    }
+
+    void clear() override
+    {
+        nodes.clear();
+        items.clear();
+        freeItems.clear();
+        freeChildren.clear();
+        nodes.push_back({boundary, -1, -1, 0, 0, -1});
+        count = 0;
+    }
+
+    void queryRange(const AABB &range, std::vector<GameObject*> &out) override
+    {
+        out.clear();
+        stack.clear();
+        stack.push_back(0);
+        while(!stack.empty())
+        {
+            int32_t node = stack.back();
+            stack.pop_back();
+            // the root can hold objects that hang over its edge, so it's always searched
+            if(node != 0 && !nodes[node].boundary.Intersects(range)) continue;
+            for(int32_t i = nodes[node].firstItem; i != -1; i = items[i].next)
+            {
+                if(items[i].bounds.Intersects(range)) out.push_back(items[i].object);
+            }
+            if(nodes[node].children != -1)
+            {
+                for(int32_t i = 0; i < 4; i++) stack.push_back(nodes[node].children + i);
+            }
+        }
+    }
+
+    size_t getCountAll() const override
+    {
+        return count;
+    }
+
+private:
+    struct Node
+    {
+        AABB boundary;
+        int32_t children;
+        int32_t firstItem;
+        uint32_t count;
+        uint32_t depth;
+        int32_t parent;
+    };
+
+    struct Item
+    {
+        GameObject* object;
+        AABB bounds;
+        int32_t node;
+        int32_t prev;
+        int32_t next;
+    };
+
+    // children are stored as four consecutive nodes: north west, north east, south west, south east
+    int32_t childContaining(int32_t node, const AABB &bounds) const
+    {
+        Vector2 c = nodes[node].boundary.center;
+        bool west = bounds.center.x + bounds.halfDimension.x <= c.x;
+        bool east = bounds.center.x - bounds.halfDimension.x >= c.x;
+        bool north = bounds.center.y + bounds.halfDimension.y <= c.y;
+        bool south = bounds.center.y - bounds.halfDimension.y >= c.y;
+        if((!west && !east) || (!north && !south)) return -1;
+        return nodes[node].children + (east ? 1 : 0) + (south ? 2 : 0);
+    }
+
+    // walks down from the root to the node the item belongs in, splitting full leaves on the way
+    void place(int32_t item)
+    {
+        if(!boundary.ContainsPoint(items[item].bounds.center)) grow(items[item].bounds.center);
+        int32_t node = 0;
+        while(boundary.ContainsPoint(items[item].bounds.center))
+        {
+            if(nodes[node].children != -1)
+            {
+                int32_t child = childContaining(node, items[item].bounds);
+                if(child == -1) break;
+                node = child;
+                continue;
+            }
+            if(nodes[node].count < nodeCapacity || nodes[node].depth >= maxDepth) break;
+            subdivide(node);
+        }
+        link(item, node);
+    }
+
+    void link(int32_t item, int32_t node)
+    {
+        items[item].node = node;
+        items[item].prev = -1;
+        items[item].next = nodes[node].firstItem;
+        if(nodes[node].firstItem != -1) items[nodes[node].firstItem].prev = item;
+        nodes[node].firstItem = item;
+        nodes[node].count++;
+    }
+
+    void unlink(int32_t item)
+    {
+        Item &i = items[item];
+        if(i.prev != -1) items[i.prev].next = i.next;
+        else nodes[i.node].firstItem = i.next;
+        if(i.next != -1) items[i.next].prev = i.prev;
+        nodes[i.node].count--;
+        i.node = -1;
+    }
+
+    // doubles the boundary until it holds point and places every item again, one level deeper so the leaves keep their size
+    void grow(Vector2 point)
+    {
+        if(!std::isfinite(point.x) || !std::isfinite(point.y)) return;
+        while(!boundary.ContainsPoint(point))
+        {
+            boundary.halfDimension.x = std::max(boundary.halfDimension.x * 2.f, 1.f);
+            boundary.halfDimension.y = std::max(boundary.halfDimension.y * 2.f, 1.f);
+            maxDepth++;
+        }
+        nodes.clear();
+        freeChildren.clear();
+        nodes.push_back({boundary, -1, -1, 0, 0, -1});
+        for(int32_t i = 0; i < (int32_t)items.size(); i++)
+        {
+            if(items[i].node == -1) continue;
+            items[i].node = -1;
+            place(i);
+        }
+    }
+
+    // the four children reuse a block given back by merge when there is one
+    void subdivide(int32_t node)
+    {
+        int32_t children;
+        if(!freeChildren.empty())
+        {
+            children = freeChildren.back();
+            freeChildren.pop_back();
+        }
+        else
+        {
+            children = nodes.size();
+            nodes.resize(nodes.size() + 4);
+        }
+        AABB b = nodes[node].boundary;
+        Vector2 half = {b.halfDimension.x / 2.f, b.halfDimension.y / 2.f};
+        uint32_t depth = nodes[node].depth + 1;
+        nodes[children] = {{{b.center.x - half.x, b.center.y - half.y}, half}, -1, -1, 0, depth, node};
+        nodes[children + 1] = {{{b.center.x + half.x, b.center.y - half.y}, half}, -1, -1, 0, depth, node};
+        nodes[children + 2] = {{{b.center.x - half.x, b.center.y + half.y}, half}, -1, -1, 0, depth, node};
+        nodes[children + 3] = {{{b.center.x + half.x, b.center.y + half.y}, half}, -1, -1, 0, depth, node};
+        nodes[node].children = children;
+
+        // push down every item that fits in one of the new children
+        int32_t item = nodes[node].firstItem;
+        nodes[node].firstItem = -1;
+        nodes[node].count = 0;
+        while(item != -1)
+        {
+            int32_t next = items[item].next;
+            int32_t target = childContaining(node, items[item].bounds);
+            link(item, target == -1 ? node : target);
+            item = next;
+        }
+    }
+
+    // called after an item leaves node, pulls the items of four leaf children back up into their parent once they'd
+    // fit in half of it, so emptied areas stop costing a visit per query. the half leaves room before it splits again
+    void merge(int32_t node)
+    {
+        int32_t parent = nodes[node].children != -1 ? node : nodes[node].parent;
+        while(parent != -1)
+        {
+            int32_t children = nodes[parent].children;
+            uint32_t total = nodes[parent].count;
+            for(int32_t i = 0; i < 4; i++)
+            {
+                if(nodes[children + i].children != -1) return;
+                total += nodes[children + i].count;
+            }
+            if(total > nodeCapacity / 2) return;
+            for(int32_t i = 0; i < 4; i++)
+            {
+                int32_t item = nodes[children + i].firstItem;
+                while(item != -1)
+                {
+                    int32_t next = items[item].next;
+                    link(item, parent);
+                    item = next;
+                }
+                nodes[children + i].firstItem = -1;
+                nodes[children + i].count = 0;
+            }
+            nodes[parent].children = -1;
+            freeChildren.push_back(children);
+            parent = nodes[parent].parent;
+        }
+    }
+
+    AABB boundary;
+    uint32_t nodeCapacity;
+    uint32_t maxDepth;
+    std::vector<Node> nodes;
+    std::vector<Item> items;
+    std::vector<int32_t> freeItems;
+    // the first of four nodes no longer in the tree after a merge
+    std::vector<int32_t> freeChildren;
+    std::vector<int32_t> stack;
+    size_t count = 0;
+};
+
+// every object whose centre lies in one grid cell
+class Chunk
+{
+public:
+    Chunk() {}
+    Chunk(int x, int y)
+    {
+        this->x = x;
+        this->y = y;
+    }
+
+    int x = 0, y = 0;
+    std::vector<uint32_t> proxies;
+};
+
+// uniform grid whose cells are found through an open addressing hash table, objects are only moved between chunks when their cell changes
+class SpatialGridHash : public SpatialIndex
+{
+public:
+    SpatialGridHash(float cellSize = 256.f)
+    {
+        this->cellSize = cellSize;
+        table.assign(64, -1);
+    }
+
+    ~SpatialGridHash()
+    {
+        clear();
+    }
+
+    uint32_t add(GameObject* object, AABB bounds) override
+    {
+        uint32_t proxy;
+        if(!freeProxies.empty())
+        {
+            proxy = freeProxies.back();
+            freeProxies.pop_back();
+        }
+        else
+        {
+            proxy = proxies.size();
+            proxies.push_back({});
+        }
+        std::pair<int, int> cell = GetChunkPos(bounds.center);
+        proxies[proxy] = {object, bounds, cell, 0, 0, true};
+        link(proxy);
+        count++;
+        return proxy;
+    }
+
+    void remove(uint32_t proxy) override
+    {
+        if(proxy >= proxies.size() || !proxies[proxy].alive) return;
+        unlink(proxy);
+        proxies[proxy].alive = false;
+        proxies[proxy].object = nullptr;
+        freeProxies.push_back(proxy);
+        count--;
+    }
+
+    // stores the new bounds, the proxy only changes chunk if its centre moved into another cell or it grew past a cell
+    void Update(uint32_t proxy, AABB bounds) override
+    {
+        Proxy &p = proxies[proxy];
+        p.bounds = bounds;
+        bool oversized = isOversized(bounds);
+        std::pair<int, int> cell = GetChunkPos(bounds.center);
+        if(oversized == (p.chunk == Oversized) && (oversized || cell == p.chunkPos)) return;
+        unlink(proxy);
+        p.chunkPos = cell;
+        link(proxy);
+    }
+
+    void queryRange(const AABB &range, std::vector<GameObject*> &out) override
+    {
+        out.clear();
+        // objects are filed by their centre and none in a chunk is bigger than a cell, so half a cell either side finds them all
+        float margin = cellSize / 2.f;
+        for(uint32_t i = 0; i < oversized.size(); i++)
+        {
+            const Proxy &p = proxies[oversized[i]];
+            if(p.bounds.Intersects(range)) out.push_back(p.object);
+        }
+        std::pair<int, int> minCell = GetChunkPos({range.center.x - range.halfDimension.x - margin, range.center.y - range.halfDimension.y - margin});
+        std::pair<int, int> maxCell = GetChunkPos({range.center.x + range.halfDimension.x + margin, range.center.y + range.halfDimension.y + margin});
+        uint64_t cells = (uint64_t)(maxCell.first - minCell.first + 1) * (uint64_t)(maxCell.second - minCell.second + 1);
+        if(cells > chunks.size())
+        {
+            // cheaper to walk every chunk than to probe every cell of a huge range
+            for(uint32_t i = 0; i < chunks.size(); i++)
+            {
+                if(chunks[i].x < minCell.first || chunks[i].x > maxCell.first || chunks[i].y < minCell.second || chunks[i].y > maxCell.second) continue;
+                collect(chunks[i], range, out);
+            }
+            return;
+        }
+        for(int y = minCell.second; y <= maxCell.second; y++)
+        {
+            for(int x = minCell.first; x <= maxCell.first; x++)
+            {
+                int32_t chunk = findChunk(x, y, false);
+                if(chunk != -1) collect(chunks[chunk], range, out);
+            }
+        }
+    }
+
+    void clear() override
+    {
+        chunks.clear();
+        table.assign(64, -1);
+        proxies.clear();
+        freeProxies.clear();
+        oversized.clear();
+        count = 0;
+    }
+
+    std::pair<int, int> GetChunkPos(Vector2 position) const
+    {
+        return {(int)std::floor(position.x / cellSize), (int)std::floor(position.y / cellSize)};
+    }
+
+    size_t getCountAll() const override
+    {
+        return count;
+    }
+
+private:
+    struct Proxy
+    {
+        GameObject* object;
+        AABB bounds;
+        std::pair<int, int> chunkPos;
+        uint32_t chunk;
+        uint32_t slot;
+        bool alive;
+    };
+
+    void collect(const Chunk &chunk, const AABB &range, std::vector<GameObject*> &out)
+    {
+        for(uint32_t i = 0; i < chunk.proxies.size(); i++)
+        {
+            const Proxy &p = proxies[chunk.proxies[i]];
+            if(p.bounds.Intersects(range)) out.push_back(p.object);
+        }
+    }
+
+    // the chunk of proxies bigger than a cell, which are kept in their own list and checked by every query
+    static constexpr uint32_t Oversized = 0xFFFFFFFF;
+
+    bool isOversized(const AABB &bounds) const
+    {
+        return bounds.halfDimension.x > cellSize / 2.f || bounds.halfDimension.y > cellSize / 2.f;
+    }
+
+    void link(uint32_t proxy)
+    {
+        Proxy &p = proxies[proxy];
+        if(isOversized(p.bounds))
+        {
+            p.chunk = Oversized;
+            p.slot = oversized.size();
+            oversized.push_back(proxy);
+            return;
+        }
+        p.chunk = findChunk(p.chunkPos.first, p.chunkPos.second, true);
+        p.slot = chunks[p.chunk].proxies.size();
+        chunks[p.chunk].proxies.push_back(proxy);
+    }
+
+    // swap-removes the proxy from its chunk
+    void unlink(uint32_t proxy)
+    {
+        Proxy &p = proxies[proxy];
+        std::vector<uint32_t> &list = p.chunk == Oversized ? oversized : chunks[p.chunk].proxies;
+        uint32_t last = list.back();
+        list[p.slot] = last;
+        proxies[last].slot = p.slot;
+        list.pop_back();
+    }
+
+    uint32_t hash(int x, int y) const
+    {
+        return ((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u);
+    }
+
+    // linear probing, chunks are never removed so empty slots always end a probe
+    int32_t findChunk(int x, int y, bool create)
+    {
+        uint32_t mask = table.size() - 1;
+        uint32_t i = hash(x, y) & mask;
+        while(table[i] != -1)
+        {
+            const Chunk &chunk = chunks[table[i]];
+            if(chunk.x == x && chunk.y == y) return table[i];
+            i = (i + 1) & mask;
+        }
+        if(!create) return -1;
+        chunks.push_back(Chunk(x, y));
+        table[i] = chunks.size() - 1;
+        if(chunks.size() * 2 > table.size()) rehash();
+        return chunks.size() - 1;
+    }
+
+    void rehash()
+    {
+        table.assign(table.size() * 2, -1);
+        uint32_t mask = table.size() - 1;
+        for(uint32_t c = 0; c < chunks.size(); c++)
+        {
+            uint32_t i = hash(chunks[c].x, chunks[c].y) & mask;
+            while(table[i] != -1) i = (i + 1) & mask;
+            table[i] = c;
+        }
+    }
+
+    float cellSize;
+    std::vector<Chunk> chunks;
+    std::vector<int32_t> table;
+    std::vector<Proxy> proxies;
+    std::vector<uint32_t> freeProxies;
+    // usually empty, a few large backgrounds or zones at most
+    std::vector<uint32_t> oversized;
+    size_t count = 0;
+};
+
+class Time
+{
+public:
+    Time() {}
+    float deltaTime;
+    float time;
+    float frameRate;
+};
+
+class Math
+{
+public:
+    Math() {}
+    
+    double e = (double)2.7182818284590452353602874713527;
+    double pi = (double)3.141592654;
+
+    uint32_t Random()
+    {
+        lehmer += 0xe120fc15;
+        uint64_t tmp;
+        tmp = (uint64_t)lehmer * 0x4a39b70d;
+        uint32_t m1 = (tmp >> 32) ^ tmp;
+        tmp = (uint64_t)m1 * 0x12fad5c9;
+        uint32_t m2 = (tmp >> 32) ^ tmp;
+        return m2;
+    }
+
+    int Random(int min, int max)
+    {
+        lehmer += 0xe120fc15;
+        uint64_t tmp;
+        tmp = (uint64_t)lehmer * 0x4a39b70d;
+        uint32_t m1 = (tmp >> 32) ^ tmp;
+        tmp = (uint64_t)m1 * 0x12fad5c9;
+        uint32_t m2 = (tmp >> 32) ^ tmp;
+        return (m2 % (max - min)) + min;
+    }
+
+    float Random(float min, float max)
+    {
+        lehmer += 0xe120fc15;
+        uint64_t tmp;
+        tmp = (uint64_t)lehmer * 0x4a39b70d;
+        uint32_t m1 = (tmp >> 32) ^ tmp;
+        tmp = (uint64_t)m1 * 0x12fad5c9;
+        uint32_t m2 = (tmp >> 32) ^ tmp;
+        float result = m2 / MAX_FLOAT;
+        return (result * (max - min)) + min;
+    }
+
+    double Random(double min, double max)
+    {
+        lehmer += 0xe120fc15;
+        uint64_t tmp;
+        tmp = (uint64_t)lehmer * 0x4a39b70d;
+        uint32_t m1 = (tmp >> 32) ^ tmp;
+        tmp = (uint64_t)m1 * 0x12fad5c9;
+        uint32_t m2 = (tmp >> 32) ^ tmp;
+        double result = m2 / MAX_FLOAT;
+        return (result * (max - min)) + min;
+    }
+
+    void Seed(uint32_t seed)
+    {
+        lehmer = seed;
+    }
+
+    // float DotProduct(Vector2 VecA, Vector2 VecB)
+    // {
+    //     return (VecA.x * VecB.x) + (VecA.y * VecB.y);
+    // }
+
+    // float Magnitude(Vector2 Vec)
+    // {
+    //     return sqrt((Vec.x * Vec.x) + (Vec.y * Vec.y));
+    // }
+
+    Vector2 Rotate(Vector2 Vec, Vector2 Origin, float Angle)
+    {
+        float s = sin(Angle);
+        float c = cos(Angle);
+
+        Vec.Sub(Origin);
+
+        float x = Vec.x * c - Vec.y * s;
+        float y = Vec.x * s + Vec.y * c;
+
+        return {x + Origin.x, y + Origin.y};
+    }
+
+    long double Sigmoid(double x)
+    {
+        return (long double)1.f / ((long double)1.f + (long double)std::pow((long double)e, (long double)-x));
+    }
+
+    float Lerp(float src, float dst, float percent)
+    {
+        float tmp = dst - src;
+        tmp *= percent;
+        return src + tmp;
+    }
+
+    float Clamp(float value, float min, float max)
+    {
+        if(value < min) value = min;
+        if(value > max) value = max;
+        return value;
+    }
+
+private:
+    uint32_t lehmer = 0;
+};
+
+class Input
+{
+public:
+    Input() {}
+
+    typedef sf::Keyboard::Key Key;
+    typedef sf::Mouse::Button MouseButton;
+
+    bool GetKey(int key)
+    {
+        if(keys.count(key) > 0)
+        {
+            return keys.at(key);
+        }
+    }
+
+    bool GetKeyDown(int key)
+    {
+        if(keys.count(key) > 0)
+        {
+            return keysPressed[key];
+        }
+    }
+
+    bool GetKeyUp(int key)
+    {
+        if(keys.count(key) > 0)
+        {
+            return keysReleased[key];
+        }
+    }
+
+    bool GetButton(int button)
+    {
+        if(buttons.count(button) > 0)
+        {
+            return buttons.at(button);
+        }
+    }
+
+    bool GetButtonDown(int button)
+    {
+        if(buttons.count(button) > 0)
+        {
+            return buttonsPressed[button];
+        }
+    }
+
+    bool GetButtonUp(int button)
+    {
+        if(buttons.count(button) > 0)
+        {
+            return buttonsReleased[button];
+        }
+    }
+
+    Vector2 GetMousePos()
+    {
+        return mousePos;
+    }
+
+    float GetMouseX()
+    {
+        return mousePos.x;
+    }
+
+    float GetMouseY()
+    {
+        return mousePos.y;
+    }
+
+    float GetMouseWheel()
+    {
+        return scrollWheel;
+    }
+
+    std::string GetTextTyped()
+    {
+        return text;
+    }
+
+    void _update()
+    {
+        for(int i = 0; i < Key::KeyCount; i++)
+        {
+            keysPressed[i] = false;
+            keysReleased[i] = false;
+        }
+
+        for(int i = 0; i < MouseButton::ButtonCount; i++)
+        {
+            buttonsPressed[i] = false;
+            buttonsReleased[i] = false;
+        }
+        text = "";
+    }
+
+    void _poll(sf::Event event)
+    {
+        switch(event.type)
+        {
+            case sf::Event::KeyPressed:
+            {
+                keys.at(event.key.code) = true;
+                keysPressed.at(event.key.code) = true;
+                break;
+            }
+            case sf::Event::KeyReleased:
+            {
+                keys.at(event.key.code) = false;
+                keysReleased.at(event.key.code) = true;
+                break;
+            }
+            case sf::Event::MouseButtonPressed:
+            {
+                buttons.at(event.key.code) = true;
+                buttonsPressed.at(event.mouseButton.button) = true;
+                break;
+            }
+            case sf::Event::MouseButtonReleased:
+            {
+                buttons.at(event.key.code) = false;
+                buttonsReleased.at(event.mouseButton.button) = true;
+                break;
+            }
+            case sf::Event::MouseMoved:
+            {
+                mousePos.x = event.mouseMove.x;
+                mousePos.y = event.mouseMove.y;
+                break;
+            }
+            case sf::Event::MouseWheelScrolled:
+            {
+                scrollWheel += event.mouseWheelScroll.delta;
+                break;
+            }
+            case sf::Event::TextEntered:
+            {
+                text = text + static_cast<char>(event.text.unicode);
+            }
+        }
+    }
+
+    void _setup()
+    {
+        if(hasSetup) return;
+        hasSetup = true;
+
+        for(int i = 0; i < Key::KeyCount; i++)
+        {
+            keys.insert({i, false});
+            keysPressed.insert({i, false});
+            keysReleased.insert({i, false});
+        }
+
+        for(int i = 0; i < MouseButton::ButtonCount; i++)
+        {
+            buttons.insert({i, false});
+            buttonsPressed.insert({i, false});
+            buttonsPressed.insert({i, false});
+        }
+    }
+
+private:
+    std::map<int, bool> keys;
+    std::map<int, bool> keysPressed;
+    std::map<int, bool> keysReleased;
+    std::map<int, bool> buttons;
+    std::map<int, bool> buttonsPressed;
+    std::map<int, bool> buttonsReleased;
+    Vector2 mousePos;
+    float scrollWheel;
+    bool hasSetup = false;
+    std::string text;
+};
+
+class Audio
+{
+public:
+    Audio() {}
+
+    bool AddSound(std::string name, std::string filepath)
+    {
+        if(sounds.count(name) != 0) return false;
+        sf::SoundBuffer buffer;
+        if(!buffer.loadFromFile(filepath)) return false;
+        sounds.insert({name, buffer});
+        return true;
+    }
+
+    bool RemoveSound(std::string name)
+    {
+        if(sounds.count(name) == 0) return false;
+        sounds.erase(name);
+        return true;
+    }
+
+    void RemoveAllSounds()
+    {
+        sounds.clear();
+    }
+
+    bool PlaySound(std::string name, float volume = 100.f, bool loop = false)
+    {
+        if(playing.count(name) != 0) return false;
+        playing.insert({name, {}});
+        playing.at(name).setBuffer(sounds.at(name));
+        playing.at(name).setVolume(volume);
+        playing.at(name).setLoop(loop);
+        playing.at(name).play();
+        return true;
+    }
+
+    bool PauseSound(std::string name)
+    {
+        if(playing.count(name) != 0) return false;
+        playing.at(name).pause();
+        return true;
+    }
+
+    bool StopSound(std::string name)
+    {
+        if(playing.count(name) == 0) return false;
+        playing.at(name).stop();
+        playing.erase(name);
+        return true;
+    }
+
+    void StopAllSounds()
+    {
+        std::map<std::string, sf::Sound>::iterator it = playing.begin();
+        while(it != playing.end())
+        {
+            playing.at(it->first).stop();
+        }
+        playing.clear();
+    }
+
+    bool AddMusic(std::string name, std::string filepath)
+    {
+        if(musicFiles.count(name) != 0) return false;
+        musicFiles.insert({name, filepath});
+        return true;
+    }
+
+    bool RemoveMusic(std::string name)
+    {
+        if(musicFiles.count(name) == 0) return false;
+        musicFiles.erase(name);
+        return true;
+    }
+
+    void RemoveAllMusic()
+    {
+        musicFiles.clear();
+    }
+
+    bool PlayMusic(std::string name, float volume = 100.f, bool loop = true)
+    {
+        music.stop();
+        if(musicFiles.count(name) == 0) return false;
+        if(!music.openFromFile(musicFiles.at(name))) return false;
+        music.setVolume(volume);
+        music.setLoop(loop);
+        music.play();
+    }
+
+private:
+    std::map<std::string, sf::SoundBuffer> sounds;
+    std::map<std::string, sf::Sound> playing;
+    std::map<std::string, std::string> musicFiles;
+    sf::Music music;
+    sf::SoundBuffer buffer;
+};
+
+class Transform;
+class Application;
+class GameObject;
+
+// takes objects that have just left the scene out of the application's simulated list, defined after Application
+inline void _forgetSimulated(Application* app);
+
+struct ComponentHandle
+{
+    uint32_t index = 0xFFFFFFFF;
+    uint32_t generation = 0;
+};
+
+class Script
+{
+public:
+    Script() {}
+
+    virtual void Start()
+    {
+
+    }
+
+    virtual void Update()
+    {
+
+    }
+
+    virtual void LateUpdate()
+    {
+
+    }
+
+    virtual void OnCreate()
+    {
+
+    }
+
+    virtual void OnDestroy()
+    {
+
+    }
+
+    void _setup(sf::View* camera, Time* time, Math* math, Input* input, Audio* audio, TextureManager* textures)
+    {
+        this->camera = camera;
+        this->time = time;
+        this->math = math;
+        this->input = input;
+        this->audio = audio;
+        this->textures = textures;
+    }
+
+    GameObject* self;
+    template <class T>
+    T* GetComponent()
+    {
+        return self->template GetComponent<T>();
+    }
+
+    template <class T>
+    bool HasComponent()
+    {
+        return self->template HasComponent<T>();
+    }
+
+    Application* app;
+    sf::View* camera;
+    Transform* transform;
     Time* time;
     Math* math;
     Input* input;
     Audio* audio;
+    TextureManager* textures = nullptr;
     float dt;
     bool simulated;
+    // set this in the constructor if Update only touches the script's own GameObject, so it can run on a worker thread
+    bool threadSafe = false;
+    // set when the component lives in a ComponentPool, used to give its slot back on destroy
+    ComponentHandle _handle;
+    void (*_release)(Script*) = nullptr;
+};
+
+// hands out a small sequential index per component type, used to index the lookup table in GameObject
+class ComponentType
+{
+public:
+    // a type is registered the first time it is looked up, so this is safe to call from a global's constructor. ids are
+    // only ever added, tables made before a type was registered grow a slot for it the next time it's looked up there
+    template <class T>
+    static uint32_t ID()
+    {
+        static const uint32_t id = Register<T>();
+        return id;
+    }
+
+    static uint32_t Count()
+    {
+        std::scoped_lock lock(Mutex());
+        return (uint32_t)Casts().size();
+    }
+
+    // the component as the type with this id, or nullptr if it isn't one, only used when components are added or removed
+    static void* Cast(uint32_t type, Script* component)
+    {
+        void* (*cast)(Script*);
+        {
+            std::scoped_lock lock(Mutex());
+            cast = Casts()[type];
+        }
+        return cast(component);
+    }
+
+private:
+    template <class T>
+    static uint32_t Register()
+    {
+        std::scoped_lock lock(Mutex());
+        Casts().push_back([](Script* component) -> void* { return dynamic_cast<T*>(component); });
+        return (uint32_t)Casts().size() - 1;
+    }
+
+    static std::vector<void* (*)(Script*)>& Casts()
+    {
+        static std::vector<void* (*)(Script*)> casts;
+        return casts;
+    }
+
+    // types can be looked up for the first time on different threads at once
+    static std::mutex& Mutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+};
+
+// contiguous storage for every component of type T, allocated in fixed blocks so pointers stay valid
+template <class T>
+class ComponentPool
+{
+public:
+    static ComponentPool<T>& Get()
+    {
+        static ComponentPool<T> pool;
+        return pool;
+    }
+
+    ~ComponentPool()
+    {
+        for(uint32_t i = 0; i < size; i++)
+        {
+            if(alive[i]) Slot(i)->~T();
+        }
+    }
+
+    template <typename... Args>
+    T* Create(Args&&... args)
+    {
+        uint32_t index;
+        if(!freeList.empty())
+        {
+            index = freeList.back();
+            freeList.pop_back();
+        }
+        else
+        {
+            index = size++;
+            if(index / BlockSize >= blocks.size()) blocks.push_back(std::make_unique<Block>());
+            generations.push_back(0);
+            alive.push_back(false);
+        }
+        T* component = new (Slot(index)) T(std::forward<Args>(args)...);
+        alive[index] = true;
+        count++;
+        component->_handle = {index, generations[index]};
+        component->_release = &ComponentPool<T>::Release;
+        return component;
+    }
+
+    void Destroy(ComponentHandle handle)
+    {
+        if(Find(handle) == nullptr) return;
+        Slot(handle.index)->~T();
+        alive[handle.index] = false;
+        generations[handle.index]++;
+        freeList.push_back(handle.index);
+        count--;
+    }
+
+    // returns nullptr if the handle refers to a component that has since been destroyed
+    T* Find(ComponentHandle handle)
+    {
+        if(handle.index >= size || !alive[handle.index] || generations[handle.index] != handle.generation) return nullptr;
+        return Slot(handle.index);
+    }
+
+    // visits every live component in memory order
+    template <typename Function>
+    void ForEach(Function function)
+    {
+        for(uint32_t i = 0; i < size; i++)
+        {
+            if(alive[i]) function(Slot(i));
+        }
+    }
+
+    size_t Count() const
+    {
+        return count;
+    }
+
+    static void Release(Script* component)
+    {
+        Get().Destroy(component->_handle);
+    }
+
+private:
+    ComponentPool() {}
+
+    static constexpr uint32_t BlockSize = 256;
+
+    struct Block
+    {
+        alignas(T) unsigned char data[BlockSize * sizeof(T)];
+    };
+
+    T* Slot(uint32_t index)
+    {
+        return reinterpret_cast<T*>(blocks[index / BlockSize]->data) + (index % BlockSize);
+    }
+
+    std::vector<std::unique_ptr<Block>> blocks;
+    std::vector<uint32_t> generations;
+    std::vector<bool> alive;
+    std::vector<uint32_t> freeList;
+    uint32_t size = 0;
+    size_t count = 0;
+};
+
+class Transform : public Script
+{
+public:
+    Transform() : Script()
+    {
+        transform = this;
+        threadSafe = true;
+
+        position = {0, 0};
+        scale = {1, 1};
+        rotation = 0;
+    }
+
+    ~Transform()
+    {
+        if(!marked) return;
+        std::lock_guard<std::mutex> lock(_movedMutex());
+        std::vector<Transform*>& moved = _moved();
+        moved.erase(std::find(moved.begin(), moved.end(), this));
+    }
+
+    // goes up every time the transform is marked as moved, so systems can skip objects that haven't
+    uint32_t GetVersion() const
+    {
+        return version;
+    }
+
+    // changes scripts make to their own object are noticed once the object's update has finished. anything else, like the
+    // application's OnUpdate or a network handler, has to call this after moving a transform or the move is never seen, as
+    // does changing something the bounds depend on like the sprite
+    void MarkMoved()
+    {
+        // the first move in a tick keeps where the tick started from, a transform that was never marked has nowhere earlier to be drawn from
+        if(previousTick != _tick())
+        {
+            previousPosition = version > 0 ? lastPosition : position;
+            previousScale = version > 0 ? lastScale : scale;
+            previousRotation = version > 0 ? lastRotation : rotation;
+            previousTick = _tick();
+        }
+        lastPosition = position;
+        lastScale = scale;
+        lastRotation = rotation;
+        version++;
+        if(marked) return;
+        marked = true;
+        std::lock_guard<std::mutex> lock(_movedMutex());
+        _moved().push_back(this);
+    }
+
+    // marks the transform moved if it has changed without being marked
+    void _detectMove()
+    {
+        if(position.x != lastPosition.x || position.y != lastPosition.y || scale.x != lastScale.x || scale.y != lastScale.y || rotation != lastRotation) MarkMoved();
+    }
+
+    // with a fixed time step, sprites are drawn between where the object was on the last two ticks
+    Vector2 GetRenderPosition()
+    {
+        float alpha = _alpha();
+        if(alpha >= 1.f || previousTick != _tick()) return position;
+        return {previousPosition.x + (position.x - previousPosition.x) * alpha, previousPosition.y + (position.y - previousPosition.y) * alpha};
+    }
+
+    Vector2 GetRenderScale()
+    {
+        float alpha = _alpha();
+        if(alpha >= 1.f || previousTick != _tick()) return scale;
+        return {previousScale.x + (scale.x - previousScale.x) * alpha, previousScale.y + (scale.y - previousScale.y) * alpha};
+    }
+
+    // turns the short way round, so going from 350 to 10 degrees doesn't spin back through 180
+    float GetRenderRotation()
+    {
+        float alpha = _alpha();
+        if(alpha >= 1.f || previousTick != _tick()) return rotation;
+        return previousRotation + std::remainder(rotation - previousRotation, 360.f) * alpha;
+    }
+
+    // call after teleporting the object so it isn't drawn sliding from where it was, marks it moved as well
+    void SnapInterpolation()
+    {
+        previousPosition = position;
+        previousScale = scale;
+        previousRotation = rotation;
+        previousTick = _tick();
+        MarkMoved();
+    }
+
+    // transforms save where they were the first time they are marked moved in a tick, so nothing is walked here
+    static void _beginTick()
+    {
+        ++_tick();
+    }
+
+    // every transform marked moved since the broad phase last took the list, never freed as the
+    // component pools can still be destroying marked transforms when the program exits
+    static std::vector<Transform*>& _moved()
+    {
+        static std::vector<Transform*>* moved = new std::vector<Transform*>();
+        return *moved;
+    }
+
+    static std::mutex& _movedMutex()
+    {
+        static std::mutex* mutex = new std::mutex();
+        return *mutex;
+    }
+
+    // taken by the broad phase once it has seen the move
+    void _clearMarked()
+    {
+        marked = false;
+    }
+
+    // how far the frame is between the last tick and the next, 1 draws the latest state
+    static float& _alpha()
+    {
+        static float alpha = 1.f;
+        return alpha;
+    }
+
+    static uint32_t& _tick()
+    {
+        static uint32_t tick = 0;
+        return tick;
+    }
+
+    Vector2 position = {0.f, 0.f};
+    Vector2 scale = {1.f, 1.f};
+    float rotation = 0.f;
+
+private:
+    Vector2 lastPosition = {0.f, 0.f};
+    Vector2 lastScale = {1.f, 1.f};
+    float lastRotation = 0.f;
+    uint32_t version = 0;
+    // already in the moved list
+    bool marked = false;
+    Vector2 previousPosition = {0.f, 0.f};
+    Vector2 previousScale = {1.f, 1.f};
+    float previousRotation = 0.f;
+    // objects created after the last tick started have no previous state to interpolate from
+    uint32_t previousTick = 0;
+};
+
+class Drawable : public Script
+{
+public:
+    Drawable() : Script() {}
+
+    virtual void _render(RenderBatch*, sf::RenderWindow*) {}
+    // called when the broad phase sees the transform change, even when the object isn't being rendered
+    virtual void _onTransformChanged() {}
+    // called when the object is disabled, removed from the scene or destroyed
+    virtual void _onHidden() {}
+
+    // finds the atlas page and texture rect of a sprite, false if its image hasn't been loaded yet
+    bool _locate(const Sprite &sprite, int &page, Vector2 &pos, Vector2 &size)
+    {
+        page = 0;
+        pos = sprite.pos;
+        size = sprite.size;
+        if(sprite.image.empty()) return true;
+        if(sprite.image != locatedImage)
+        {
+            locatedRegion = textures->Find(sprite.image);
+            if(locatedRegion == nullptr) return false;
+            locatedImage = sprite.image;
+        }
+        page = locatedRegion->page;
+        pos = {locatedRegion->pos.x + sprite.pos.x, locatedRegion->pos.y + sprite.pos.y};
+        if(size.x == 0 && size.y == 0) size = locatedRegion->size;
+        return true;
+    }
+
+    bool lateRender = false;
+    bool debugDrawEnabled = false;
+
+private:
+    // the last image looked up, so the name is only hashed when it changes
+    const TextureManager::Region* locatedRegion = nullptr;
+    std::string locatedImage;
+};
+
+class SpriteRenderer : public Drawable
+{
+public:
+    SpriteRenderer() : Drawable()
+    {
+        threadSafe = true;
+    }
+    SpriteRenderer(Sprite sprite) : Drawable()
+    {
+        this->sprite = sprite;
+        threadSafe = true;
+    }
+    Sprite sprite;
+    // static sprites are kept on the gpu and only uploaded again when the broad phase sees their transform change,
+    // call transform->MarkMoved() after changing the sprite. they are drawn underneath the other sprites, even while outside of the simulation distance
+    bool isStatic = false;
+
+    // the size the sprite is drawn at, a whole image sprite takes it from its region once the image has been packed
+    Vector2 _size()
+    {
+        int page;
+        Vector2 pos, size = sprite.size;
+        if(textures != nullptr) _locate(sprite, page, pos, size);
+        return size;
+    }
+
+    void _render(RenderBatch* batch, sf::RenderWindow*) override
+    {
+        int page;
+        Vector2 texPos, texSize;
+        if(!_locate(sprite, page, texPos, texSize))
+        {
+            return;
+        }
+        if(isStatic)
+        {
+            if(staticBatch == nullptr)
+            {
+                _updateStatic(batch);
+            }
+        }
+        else
+        {
+            // in case isStatic was switched off. only static sprites are kept between frames, working the quad out again
+            // costs about the same as copying one kept from the last frame, and a sprite moved without MarkMoved still shows
+            _onHidden();
+            _writeQuad(batch->AddQuad(page), texPos, texSize, transform->GetRenderPosition(), transform->GetRenderScale(), transform->GetRenderRotation());
+        }
+
+        if(debugDrawEnabled)
+        {
+            Vector2 sprScale = {transform->scale.x * texSize.x, transform->scale.y * texSize.y};
+            Vector2 sprPos = {transform->position.x - (sprScale.x / 2.f), transform->position.y - (sprScale.y / 2.f)};
+            sf::RectangleShape* rect = batch->AddDebugRect();
+            rect->setPosition(sprPos.x, sprPos.y);
+            rect->setSize({sprPos.x + sprScale.x, sprPos.y + sprScale.y});
+        }
+    }
+
+    void _onTransformChanged() override
+    {
+        if(staticBatch != nullptr)
+        {
+            _updateStatic(staticOwner);
+        }
+    }
+
+    void _onHidden() override
+    {
+        if(staticBatch != nullptr)
+        {
+            staticBatch->Remove(staticSlot);
+            staticBatch = nullptr;
+        }
+    }
+
+private:
+    // rotation is in degrees around the sprite's centre, the same way colliders turn with the transform
+    void _writeQuad(sf::Vertex* quad, Vector2 spritePos, Vector2 spriteSize, Vector2 position, Vector2 scale, float rotation)
+    {
+        Vector2 sprScale = {scale.x * spriteSize.x, scale.y * spriteSize.y};
+        Vector2 sprPos = {position.x - (sprScale.x / 2.f), position.y - (sprScale.y / 2.f)};
+        quad[0].position = {sprPos.x, sprPos.y};
+        quad[1].position = {sprPos.x + sprScale.x, sprPos.y};
+        quad[2].position = {sprPos.x + sprScale.x, sprPos.y + sprScale.y};
+        quad[3].position = {sprPos.x, sprPos.y + sprScale.y};
+        if(rotation != 0)
+        {
+            float angle = rotation * 3.14159265f / 180.f;
+            float c = std::cos(angle), s = std::sin(angle);
+            for(int i = 0; i < 4; i++)
+            {
+                sf::Vector2f offset = {quad[i].position.x - position.x, quad[i].position.y - position.y};
+                quad[i].position = {position.x + offset.x * c - offset.y * s, position.y + offset.x * s + offset.y * c};
+            }
+        }
+        quad[0].texCoords = {spritePos.x, spritePos.y};
+        quad[1].texCoords = {spritePos.x + spriteSize.x, spritePos.y};
+        quad[2].texCoords = {spritePos.x + spriteSize.x, spritePos.y + spriteSize.y};
+        quad[3].texCoords = {spritePos.x, spritePos.y + spriteSize.y};
+    }
+
+    void _updateStatic(RenderBatch* batch)
+    {
+        int page;
+        Vector2 texPos, texSize;
+        if(!_locate(sprite, page, texPos, texSize))
+        {
+            _onHidden();
+            return;
+        }
+        uint32_t version = transform->GetVersion();
+        // each atlas page has its own static batch, so a new image can mean moving to another one
+        StaticSpriteBatch* statics = batch->Statics(page);
+        if(staticBatch != statics)
+        {
+            _onHidden();
+            staticOwner = batch;
+            staticBatch = statics;
+            staticSlot = statics->Add();
+        }
+        else if(version == staticVersion && sprite.pos.x == staticSprite.pos.x && sprite.pos.y == staticSprite.pos.y &&
+                sprite.size.x == staticSprite.size.x && sprite.size.y == staticSprite.size.y && sprite.image == staticSprite.image)
+        {
+            return;
+        }
+        staticVersion = version;
+        staticSprite = sprite;
+        // static sprites aren't redrawn every frame, so they aren't interpolated
+        _writeQuad(staticBatch->Edit(staticSlot), texPos, texSize, transform->position, transform->scale, transform->rotation);
+    }
+
+    RenderBatch* staticOwner = nullptr;
+    StaticSpriteBatch* staticBatch = nullptr;
+    uint32_t staticSlot = 0;
+    uint32_t staticVersion = 0;
+    Sprite staticSprite;
+};
+
+class RigidBody;
+class SweepAndPrune;
+
+class Collider : public Script
+{
+public:
+    struct Collision
+    {
+        Collision(Collider* c1, Collider* c2, bool collision)
+        {
+            HasCollision = collision;
+            this->c1 = c1;
+            this->c2 = c2;
+        }
+
+        Collision(Collider* c1, Collider* c2, float overlap, Vector2 axis)
+        {
+            Overlap = overlap;
+            if(overlap > 0) HasCollision = true;
+            Axis = axis;
+            this->c1 = c1;
+            this->c2 = c2;
+        }
+
+        // adds a point where the two touch, for the solver to push at
+        void AddPoint(Vector2 point, float depth, uint32_t feature)
+        {
+            Points[PointCount] = point;
+            Depths[PointCount] = depth;
+            Features[PointCount] = feature;
+            PointCount++;
+        }
+
+        Collider* c1;
+        Collider* c2;
+        bool HasCollision = false;
+        float Overlap = 0.0f;
+        Vector2 Axis = {0, 0};
+        // up to two points where the shapes touch, two when poly edges lie against each other, each as deep as it is in
+        int PointCount = 0;
+        Vector2 Points[2] = {{0, 0}, {0, 0}};
+        float Depths[2] = {0, 0};
+        // which edges made each point, the same every tick while the two rest on each other the same way
+        uint32_t Features[2] = {0, 0};
+    };
+
+    enum ColliderType
+    {
+        Poly, Circle
+    };
+
+    Collider() : Script()
+    {
+        threadSafe = true;
+        _id = nextID()++;
+    }
+
+    // runs the narrow phase without moving either collider, the axis points from other towards this
+    Collision _test(Collider* other)
+    {
+        if(other == this) return {this, other, false};
+        Collision collision = resolve(other);
+        if(collision.HasCollision)
+        {
+            IsColliding = true;
+            other->IsColliding = true;
+        }
+        return collision;
+    }
+
+    // pushes the two apart by the overlap straight away, the application's solver goes through velocities instead
+    void _resolve(Collider* other)
+    {
+        Collision collision = _test(other);
+        if(!collision.HasCollision)
+        {
+            return;
+        }
+        if(_isStatic && other->_isStatic) return;
+
+        
+        if(_isStatic)
+        {
+            other->transform->position.x -= collision.Axis.x * collision.Overlap;
+            other->transform->position.y -= collision.Axis.y * collision.Overlap;
+            other->transform->MarkMoved();
+            return;
+        }
+
+        if(other->_isStatic)
+        {
+            transform->position.x += collision.Axis.x * collision.Overlap;
+            transform->position.y += collision.Axis.y * collision.Overlap;
+            transform->MarkMoved();
+            return;
+        }
+
+        other->transform->position.x -= collision.Axis.x * collision.Overlap * 0.5f;
+        other->transform->position.y -= collision.Axis.y * collision.Overlap * 0.5f;
+        transform->position.x += collision.Axis.x * collision.Overlap * 0.5f;
+        transform->position.y += collision.Axis.y * collision.Overlap * 0.5f;
+        other->transform->MarkMoved();
+        transform->MarkMoved();
+        
+        return;
+    }
+
+    Vector2 Centre;
+    Vector2 Scale = {1, 1};
+    // only applicable for polys
+    AABB bounds;
+    // in degrees, added to the transform's rotation for polys
+    float Rotation = 0;
+    // only applicable to circles
+    float Radius;
+    ColliderType Type;
+    // only applicable to polys
+    std::vector<Vector2> Vertices;
+    // don't change this, you will break the collision system
+    bool _isStatic = true;
+    bool IsColliding = false;
+
+    std::vector<Vector2> offsetAxesDebug;
+    std::vector<float> offsetDstDebug;
+    std::vector<Vector2> intersectionsDebug;
+    std::vector<GameObject*> checkedObjectsDebug;
+    // this will enable the offsetAxesDebug, offsetDstDebug, intersectionsDebug and checkedObjectsDebug vectors, which must be manually cleared each frame to prevent a memory leak
+    bool debugInfoEnabled = false;
+
+    // the poly's vertices moved, scaled and rotated into the world, with an outward normal per edge and the edges
+    // themselves, rebuilt only when the transform or the collider's shape has changed since they were last used
+    void _updateWorldVertices()
+    {
+        uint32_t version = transform->GetVersion();
+        if(worldVersion == version && worldCentre.x == Centre.x && worldCentre.y == Centre.y && worldScale.x == Scale.x &&
+           worldScale.y == Scale.y && worldRotation == Rotation && localVertices.size() == Vertices.size() &&
+           std::equal(Vertices.begin(), Vertices.end(), localVertices.begin(), [](const Vector2 &a, const Vector2 &b) { return a.x == b.x && a.y == b.y; }))
+        {
+            return;
+        }
+        worldVersion = version;
+        worldCentre = Centre;
+        worldScale = Scale;
+        worldRotation = Rotation;
+        localVertices = Vertices;
+
+        float angle = (Rotation + transform->rotation) * 3.14159265f / 180.f;
+        float c = std::cos(angle), s = std::sin(angle);
+        Vector2 scale = {Scale.x * transform->scale.x, Scale.y * transform->scale.y};
+        Vector2 origin = {transform->position.x + Centre.x, transform->position.y + Centre.y};
+        size_t count = Vertices.size();
+        worldVertices.resize(count);
+        worldNormals.resize(count);
+        worldEdges.resize(count);
+        worldMiddle = {0, 0};
+        Vector2 min = origin, max = origin;
+        for(size_t i = 0; i < count; i++)
+        {
+            float x = Vertices[i].x * scale.x, y = Vertices[i].y * scale.y;
+            worldVertices[i] = {origin.x + x * c - y * s, origin.y + x * s + y * c};
+            worldMiddle.x += worldVertices[i].x / count;
+            worldMiddle.y += worldVertices[i].y / count;
+            if(i == 0) min = max = worldVertices[i];
+            min = {std::min(min.x, worldVertices[i].x), std::min(min.y, worldVertices[i].y)};
+            max = {std::max(max.x, worldVertices[i].x), std::max(max.y, worldVertices[i].y)};
+        }
+        worldBounds = AABB({(min.x + max.x) / 2.f, (min.y + max.y) / 2.f}, {(max.x - min.x) / 2.f, (max.y - min.y) / 2.f});
+        for(size_t i = 0; i < count; i++)
+        {
+            Vector2 a = worldVertices[i], b = worldVertices[i + 1 == count ? 0 : i + 1];
+            Vector2 normal = {b.y - a.y, a.x - b.x};
+            float length = normal.Mag();
+            // a zero length edge has no normal and is skipped
+            if(length > 0) normal = {normal.x / length, normal.y / length};
+            else normal = {0, 0};
+            // winding isn't fixed, so point it away from the middle
+            if(normal.x * (a.x - worldMiddle.x) + normal.y * (a.y - worldMiddle.y) < 0) normal = {-normal.x, -normal.y};
+            worldNormals[i] = normal;
+
+            worldEdges.x[i] = a.x;
+            worldEdges.y[i] = a.y;
+            worldEdges.dx[i] = b.x - a.x;
+            worldEdges.dy[i] = b.y - a.y;
+            worldEdges.inverseLengthSq[i] = length > 0 ? 1.f / (length * length) : 0.f;
+            worldEdges.normalX[i] = normal.x;
+            worldEdges.normalY[i] = normal.y;
+        }
+    }
+
+    const std::vector<Vector2>& _worldVertices()
+    {
+        _updateWorldVertices();
+        return worldVertices;
+    }
+
+    // the box around the collider in the world, what the broad phase sorts by
+    AABB _worldBounds()
+    {
+        if(Type == Circle) return AABB({transform->position.x + Centre.x, transform->position.y + Centre.y}, {Radius, Radius});
+        _updateWorldVertices();
+        return worldBounds;
+    }
+
+    // the collider's place in the application's sweep and prune, NoProxy while it isn't in it
+    uint32_t _sweepProxy = SpatialIndex::NoProxy;
+    SweepAndPrune* _sweep = nullptr;
+    // set by the object's RigidBody
+    RigidBody* _body = nullptr;
+    // never handed out twice, so what the solver remembers about a destroyed collider can't carry over to a new one in its slot
+    uint32_t _id;
+
+    // the point the collider turns about, where its body's mass is taken to be
+    Vector2 _pivot()
+    {
+        return {transform->position.x + Centre.x, transform->position.y + Centre.y};
+    }
+
+    // the moment of inertia about the pivot for the given mass, spread evenly over the shape
+    float _inertia(float mass)
+    {
+        if(Type == Circle) return mass * Radius * Radius / 2.f;
+        _updateWorldVertices();
+        Vector2 pivot = _pivot();
+        float area = 0, moment = 0;
+        for(size_t i = 0; i < worldVertices.size(); i++)
+        {
+            Vector2 a = worldVertices[i], b = worldVertices[i + 1 == worldVertices.size() ? 0 : i + 1];
+            a = {a.x - pivot.x, a.y - pivot.y};
+            b = {b.x - pivot.x, b.y - pivot.y};
+            float cross = a.x * b.y - a.y * b.x;
+            area += cross;
+            moment += cross * (a.x * a.x + a.y * a.y + a.x * b.x + a.y * b.y + b.x * b.x + b.y * b.y);
+        }
+        // both sums flip sign with the winding, so the ratio doesn't
+        return area != 0 ? mass * moment / (6.f * area) : 0.f;
+    }
+
+private:
+    Collision resolve(Collider* other)
+    {
+        if(debugInfoEnabled) checkedObjectsDebug.push_back(other->self);
+        Vector2 v1 = {Centre.x + transform->position.x, Centre.y + transform->position.y};
+        Vector2 v2 = {other->Centre.x + other->transform->position.x, other->Centre.y + other->transform->position.y};
+
+        if(Type == Circle && other->Type == Circle)
+        {
+            float f1 = Radius;
+            float f2 = other->Radius;
+            float minDst = f1 + f2;
+
+            Vector2 delta = {v1.x - v2.x, v1.y - v2.y};
+            float dst = delta.Mag();
+
+            if(debugInfoEnabled && dst != 0)
+            {
+                Vector2 debugAxis;
+                debugAxis.x = delta.x / dst;
+                debugAxis.y = delta.y / dst;
+                offsetAxesDebug.push_back(debugAxis);
+                offsetDstDebug.push_back(dst);
+            }
+
+            if(dst < minDst && dst != 0)
+            {
+                Vector2 axis;
+                axis.x = delta.x / dst;
+                axis.y = delta.y / dst;
+
+                if(debugInfoEnabled) intersectionsDebug.push_back({(axis.x * -Radius) + v1.x, (axis.y * -Radius) + v1.y});
+
+                Collision collision = {this, other, (minDst - dst) + 1.f, axis};
+                // halfway between the two surfaces
+                float middle = (Radius - f2 + dst) / 2.f;
+                collision.AddPoint({v1.x - axis.x * middle, v1.y - axis.y * middle}, minDst - dst, 0);
+                return collision;
+            }
+
+            return {this, other, false};
+        }
+
+        if(Type == Poly && other->Type == Circle)
+        {
+            return circleVsPoly(v2, other->Radius, this, other);
+        }
+
+        if(Type == Circle && other->Type == Poly)
+        {
+            return circleVsPoly(v1, Radius, other, other);
+        }
+
+        if(Type == Poly && other->Type == Poly)
+        {
+            return polyVsPoly(other);
+        }
+
+        return {this, other, false};
+    }
+
+    // separating axis test over both polys' edge normals, the edge the other poly is least deep behind is the way out.
+    // the other poly's edge that faces it most is clipped to it for the contact points
+    Collision polyVsPoly(Collider* other)
+    {
+        _updateWorldVertices();
+        other->_updateWorldVertices();
+        if(worldVertices.size() < 3 || other->worldVertices.size() < 3) return {this, other, false};
+
+        size_t edge, otherEdge;
+        float separation = deepestSeparation(this, other, edge);
+        if(separation > 0) return {this, other, false};
+        float otherSeparation = deepestSeparation(other, this, otherEdge);
+        if(otherSeparation > 0) return {this, other, false};
+
+        // this poly's edge is kept unless the other's is clearly better, so resting contacts don't flip between the two
+        Collider* reference = this;
+        Collider* incident = other;
+        if(otherSeparation > separation * 0.95f + 0.01f)
+        {
+            reference = other;
+            incident = this;
+            edge = otherEdge;
+            separation = otherSeparation;
+        }
+        Vector2 normal = reference->worldNormals[edge];
+        // point the axis from the other poly to this one, the way the other shapes report it
+        Vector2 axis = reference == this ? Vector2(-normal.x, -normal.y) : normal;
+        Collision collision = {this, other, -separation + 1.f, axis};
+
+        // the incident edge is the one facing most against the reference edge's normal
+        size_t count = incident->worldVertices.size();
+        size_t facing = 0;
+        float least = std::numeric_limits<float>::max();
+        for(size_t i = 0; i < count; i++)
+        {
+            const Vector2 &n = incident->worldNormals[i];
+            if(n.x == 0 && n.y == 0) continue;
+            float d = n.x * normal.x + n.y * normal.y;
+            if(d < least)
+            {
+                least = d;
+                facing = i;
+            }
+        }
+        Vector2 clipped[2] = {incident->worldVertices[facing], incident->worldVertices[facing + 1 == count ? 0 : facing + 1]};
+
+        // cut the incident edge down to the part between the ends of the reference edge
+        const std::vector<Vector2> &vertices = reference->worldVertices;
+        Vector2 start = vertices[edge], end = vertices[edge + 1 == vertices.size() ? 0 : edge + 1];
+        Vector2 tangent = {end.x - start.x, end.y - start.y};
+        if(!clip(clipped, {-tangent.x, -tangent.y}, -(tangent.x * start.x + tangent.y * start.y)) ||
+           !clip(clipped, tangent, tangent.x * end.x + tangent.y * end.y))
+        {
+            // only when the edges barely touch at a corner, the nearer incident end is as good as anything
+            clipped[0] = clipped[1] = incident->worldVertices[facing];
+        }
+
+        // the ids only depend on which collider is which, not on which way round the pair was tested
+        uint32_t feature = (uint32_t(edge) << 16) | (uint32_t(facing) << 2) | (reference->_id > incident->_id ? 1 : 0);
+        for(int i = 0; i < 2; i++)
+        {
+            float depth = -(normal.x * (clipped[i].x - start.x) + normal.y * (clipped[i].y - start.y));
+            if(depth < 0) continue;
+            if(i == 1 && collision.PointCount == 1 && clipped[1].x == clipped[0].x && clipped[1].y == clipped[0].y) continue;
+            // halfway between the incident point and the reference edge
+            collision.AddPoint({clipped[i].x + normal.x * depth / 2.f, clipped[i].y + normal.y * depth / 2.f}, depth, feature | (uint32_t(i) << 1));
+        }
+        if(collision.PointCount == 0) collision.AddPoint(clipped[0], -separation, feature);
+
+        if(debugInfoEnabled)
+        {
+            offsetAxesDebug.push_back(axis);
+            offsetDstDebug.push_back(-separation);
+        }
+        if(other->debugInfoEnabled)
+        {
+            other->offsetAxesDebug.push_back(axis);
+            other->offsetDstDebug.push_back(separation);
+        }
+        return collision;
+    }
+
+    // how far the other poly's nearest vertex is in front of each of the poly's edges, the largest of those is returned
+    // with its edge, above zero means that edge separates the two
+    static float deepestSeparation(Collider* poly, Collider* other, size_t &edge)
+    {
+        float best = -std::numeric_limits<float>::max();
+        edge = 0;
+        for(size_t i = 0; i < poly->worldVertices.size(); i++)
+        {
+            const Vector2 &normal = poly->worldNormals[i];
+            if(normal.x == 0 && normal.y == 0) continue;
+            const Vector2 &start = poly->worldVertices[i];
+            float nearest = std::numeric_limits<float>::max();
+            for(const Vector2 &v : other->worldVertices)
+            {
+                nearest = std::min(nearest, normal.x * (v.x - start.x) + normal.y * (v.y - start.y));
+            }
+            if(nearest > best)
+            {
+                best = nearest;
+                edge = i;
+                if(best > 0) return best;
+            }
+        }
+        return best;
+    }
+
+    // keeps the part of the segment where dot(normal, p) <= offset, false if none of it is
+    static bool clip(Vector2 (&segment)[2], Vector2 normal, float offset)
+    {
+        float d0 = normal.x * segment[0].x + normal.y * segment[0].y - offset;
+        float d1 = normal.x * segment[1].x + normal.y * segment[1].y - offset;
+        if(d0 > 0 && d1 > 0) return false;
+        if(d0 > 0 || d1 > 0)
+        {
+            float t = d0 / (d0 - d1);
+            Vector2 cut = {segment[0].x + (segment[1].x - segment[0].x) * t, segment[0].y + (segment[1].y - segment[0].y) * t};
+            if(d0 > 0) segment[0] = cut;
+            else segment[1] = cut;
+        }
+        return true;
+    }
+
+    // tests the circle against every edge of the poly's cached world edges, the axis points towards this collider
+    // whichever of the two shapes it is
+    Collision circleVsPoly(Vector2 circlePos, float radius, Collider* poly, Collider* other)
+    {
+        poly->_updateWorldVertices();
+        const Edges &edges = poly->worldEdges;
+        size_t count = edges.x.size();
+        if(count < 2) return {this, other, false};
+
+        edgeDistances.resize(count);
+        edgeSides.resize(count);
+        const float *x = edges.x.data(), *y = edges.y.data(), *dx = edges.dx.data(), *dy = edges.dy.data();
+        const float *inverseLengthSq = edges.inverseLengthSq.data(), *normalX = edges.normalX.data(), *normalY = edges.normalY.data();
+        float *distances = edgeDistances.data(), *sides = edgeSides.data();
+
+        // squared distance to the closest point on each edge and which side of it the centre is on,
+        // kept free of branches so the compiler can do every edge in one vectorized pass
+        for(size_t i = 0; i < count; i++)
+        {
+            float px = circlePos.x - x[i];
+            float py = circlePos.y - y[i];
+            float t = std::max(0.f, std::min(1.f, (px * dx[i] + py * dy[i]) * inverseLengthSq[i]));
+            float ox = px - t * dx[i];
+            float oy = py - t * dy[i];
+            distances[i] = ox * ox + oy * oy;
+            sides[i] = px * normalX[i] + py * normalY[i];
+        }
+
+        size_t nearest = 0;
+        float outside = sides[0];
+        for(size_t i = 1; i < count; i++)
+        {
+            if(distances[i] < distances[nearest]) nearest = i;
+            outside = std::max(outside, sides[i]);
+        }
+
+        if(debugInfoEnabled || other->debugInfoEnabled)
+        {
+            for(size_t i = 0; i < count; i++)
+            {
+                float distance = std::sqrt(distances[i]);
+                Vector2 delta = {normalX[i], normalY[i]};
+                if(distance > 0)
+                {
+                    float t = std::max(0.f, std::min(1.f, ((circlePos.x - x[i]) * dx[i] + (circlePos.y - y[i]) * dy[i]) * inverseLengthSq[i]));
+                    delta = {(circlePos.x - x[i] - t * dx[i]) / distance, (circlePos.y - y[i] - t * dy[i]) / distance};
+                }
+                if(debugInfoEnabled)
+                {
+                    offsetAxesDebug.push_back(delta);
+                    offsetDstDebug.push_back(distance);
+                }
+                if(other->debugInfoEnabled)
+                {
+                    other->offsetAxesDebug.push_back(delta);
+                    other->offsetDstDebug.push_back(-distance);
+                }
+            }
+        }
+
+        float distance = std::sqrt(distances[nearest]);
+        // a centre behind every edge is inside the poly and has to go all the way out through the nearest one
+        bool inside = outside < 0;
+        if(!inside && distance >= radius) return {this, other, false};
+
+        float t = std::max(0.f, std::min(1.f, ((circlePos.x - x[nearest]) * dx[nearest] + (circlePos.y - y[nearest]) * dy[nearest]) * inverseLengthSq[nearest]));
+        Vector2 closest = {x[nearest] + t * dx[nearest], y[nearest] + t * dy[nearest]};
+        if(debugInfoEnabled) intersectionsDebug.push_back(closest);
+        if(other->debugInfoEnabled) other->intersectionsDebug.push_back(closest);
+
+        // from the poly to the circle
+        Vector2 axis = {normalX[nearest], normalY[nearest]};
+        float overlap = radius + distance;
+        if(!inside)
+        {
+            if(distance > 0) axis = {(circlePos.x - closest.x) / distance, (circlePos.y - closest.y) / distance};
+            overlap = radius - distance;
+        }
+        // halfway between the poly's edge and the deepest point of the circle
+        Vector2 point = {(closest.x + circlePos.x - axis.x * radius) / 2.f, (closest.y + circlePos.y - axis.y * radius) / 2.f};
+        if(poly == this) axis = {-axis.x, -axis.y};
+        Collision collision = {this, other, overlap + 1.f, axis};
+        collision.AddPoint(point, overlap, 0);
+        return collision;
+    }
+
+    static std::atomic<uint32_t>& nextID()
+    {
+        static std::atomic<uint32_t> id{0};
+        return id;
+    }
+
+    // one array per component rather than one struct per edge
+    struct Edges
+    {
+        std::vector<float> x, y, dx, dy, inverseLengthSq, normalX, normalY;
+
+        void resize(size_t count)
+        {
+            x.resize(count);
+            y.resize(count);
+            dx.resize(count);
+            dy.resize(count);
+            inverseLengthSq.resize(count);
+            normalX.resize(count);
+            normalY.resize(count);
+        }
+    };
+
+    std::vector<Vector2> worldVertices;
+    std::vector<Vector2> worldNormals;
+    Edges worldEdges;
+    AABB worldBounds = AABB({0, 0}, {0, 0});
+    Vector2 worldMiddle = {0, 0};
+    // scratch for circleVsPoly, kept so it doesn't allocate once it has grown to the largest poly
+    std::vector<float> edgeDistances;
+    std::vector<float> edgeSides;
+    // what the world vertices were built from
+    std::vector<Vector2> localVertices;
+    uint32_t worldVersion = 0;
+    Vector2 worldCentre = {0, 0};
+    Vector2 worldScale = {0, 0};
+    float worldRotation = 0;
+};
+
+// This will not work if there is not already a collider when OnCreate() is called
+class RigidBody : public Script
+{
+public:
+    RigidBody() : Script()
+    {
+        threadSafe = true;
+    }
+
+    void OnCreate() override
+    {
+        if(!HasComponent<Collider>())
+        {
+            std::cout << "Error: RigidBody has no collider\n";
+            exit(1);
+        }
+        collider = GetComponent<Collider>();
+        collider->_isStatic = false;
+        collider->_body = this;
+    }
+
+    void OnDestroy() override
+    {
+        collider->_isStatic = true;
+        collider->_body = nullptr;
+    }
+
+    // applied over the next collision tick, then cleared
+    void AddForce(Vector2 force)
+    {
+        _force.x += force.x;
+        _force.y += force.y;
+    }
+
+    // changes the velocity straight away
+    void AddImpulse(Vector2 impulse)
+    {
+        Velocity.x += impulse.x * _inverseMass();
+        Velocity.y += impulse.y * _inverseMass();
+    }
+
+    // a sleeping body isn't moved or collision tested until something touches it or a script moves it
+    bool IsSleeping() const
+    {
+        return _sleeping;
+    }
+
+    void WakeUp()
+    {
+        _sleeping = false;
+        _restTime = 0;
+    }
+
+    void _sleep()
+    {
+        _sleeping = true;
+        Velocity = {0, 0};
+        AngularVelocity = 0;
+        _sleepVersion = transform->GetVersion();
+    }
+
+    // anything a script could have done to a sleeping body that should wake it
+    bool _disturbed()
+    {
+        return Velocity.x != 0 || Velocity.y != 0 || AngularVelocity != 0 || _force.x != 0 || _force.y != 0 ||
+               transform->GetVersion() != _sleepVersion;
+    }
+
+    float _inverseMass() const
+    {
+        return Mass > 0 ? 1.f / Mass : 0.f;
+    }
+
+    void _integrateVelocity(Vector2 gravity, float dt)
+    {
+        float inverseMass = _inverseMass();
+        // bodies without mass only move the way scripts tell them to
+        if(inverseMass == 0) gravity = {0, 0};
+        Velocity.x += (gravity.x * GravityScale + _force.x * inverseMass) * dt;
+        Velocity.y += (gravity.y * GravityScale + _force.y * inverseMass) * dt;
+        // stays stable however large dt or the damping gets, unlike scaling by 1 - damping * dt
+        float damping = 1.f / (1.f + dt * LinearDamping);
+        Velocity.x *= damping;
+        Velocity.y *= damping;
+        AngularVelocity /= 1.f + dt * AngularDamping;
+        _force = {0, 0};
+        // the shape can change between ticks, so this is worked out again each tick the body is stepped
+        float inertia = FixedRotation || inverseMass == 0 ? 0.f : collider->_inertia(Mass);
+        _inverseInertia = inertia > 0 ? 1.f / inertia : 0.f;
+    }
+
+    // the solver's push out of overlaps moves the body this tick only, it never turns into speed
+    void _integratePosition(float dt)
+    {
+        Vector2 move = {(Velocity.x + _pushVelocity.x) * dt, (Velocity.y + _pushVelocity.y) * dt};
+        float turn = (AngularVelocity + _pushAngularVelocity) * dt * 180.f / 3.14159265f;
+        _pushVelocity = {0, 0};
+        _pushAngularVelocity = 0;
+        if(move.x == 0 && move.y == 0 && turn == 0) return;
+        transform->position.x += move.x;
+        transform->position.y += move.y;
+        transform->rotation += turn;
+        transform->MarkMoved();
+    }
+
+    Collider* collider;
+    // in pixels per second
+    Vector2 Velocity = {0, 0};
+    // in radians per second, positive turns the same way as the transform's rotation
+    float AngularVelocity = 0;
+    // 0 or less isn't pushed by anything it touches, but still pushes everything else
+    float Mass = 1;
+    // 0 stops dead on contact, 1 bounces back at the same speed
+    float Restitution = 0;
+    float Friction = 0.3f;
+    // how much of the application's gravity this body feels
+    float GravityScale = 1;
+    // the fraction of its velocity, roughly, the body loses every second, 0 keeps it moving forever
+    float LinearDamping = 0;
+    float AngularDamping = 0;
+    // never turned by what it touches, for bodies like the player that should stay upright
+    bool FixedRotation = false;
+    // turn off for bodies a script watches every tick, like the player
+    bool CanSleep = true;
+    Vector2 _force = {0, 0};
+    // one over the moment of inertia about the collider's pivot, 0 when nothing can turn the body
+    float _inverseInertia = 0;
+    // how fast the solver is pushing the body out of overlaps this tick, thrown away once it has moved
+    Vector2 _pushVelocity = {0, 0};
+    float _pushAngularVelocity = 0;
+    // how long the body has been slower than the application's sleepVelocity
+    float _restTime = 0;
+    bool _sleeping = false;
+    // the transform version when it fell asleep
+    uint32_t _sleepVersion = 0;
+    // the solver is keeping what its contacts needed from when it fell asleep
+    bool _resting = false;
+    // where the body is in this tick's islands, NoIsland unless it is being stepped this tick
+    uint32_t _island = NoIsland;
+    static constexpr uint32_t NoIsland = 0xFFFFFFFF;
+};
+
+// every collider's bounds as a min and a max end along x, kept sorted between ticks so sorting again after things
+// have moved a little is close to one pass, then a single sweep over the ends finds each overlapping pair once
+class SweepAndPrune
+{
+public:
+    struct Pair
+    {
+        Collider* a;
+        Collider* b;
+    };
+
+    uint32_t Add(Collider* collider, const AABB &bounds)
+    {
+        uint32_t proxy;
+        if(!freeProxies.empty())
+        {
+            proxy = freeProxies.back();
+            freeProxies.pop_back();
+        }
+        else
+        {
+            proxy = proxies.size();
+            proxies.push_back({});
+            extents.push_back({});
+            openSlots.push_back(0);
+        }
+        proxies[proxy] = {collider, collider->_isStatic, true, true};
+        collider->_sweepProxy = proxy;
+        collider->_sweep = this;
+        extents[proxy] = bounds;
+        // the new ends are merged in by the next FindPairs
+        endpoints.push_back({0, proxy, 0, 0, false, false});
+        endpoints.push_back({0, proxy, 0, 0, true, false});
+        count++;
+        return proxy;
+    }
+
+    // static here just means it won't move this tick, two of them are never paired
+    void Update(uint32_t proxy, const AABB &bounds, bool isStatic)
+    {
+        extents[proxy] = bounds;
+        proxies[proxy].isStatic = isStatic;
+        proxies[proxy].touched = true;
+    }
+
+    // for proxies that haven't moved
+    void SetStatic(uint32_t proxy, bool isStatic)
+    {
+        proxies[proxy].isStatic = isStatic;
+        proxies[proxy].touched = true;
+    }
+
+    // leaves the proxy where it is until the next RemoveUntouched, for a sleeping body that is already static here
+    void Keep(uint32_t proxy)
+    {
+        proxies[proxy].touched = true;
+    }
+
+    // the proxy isn't reused until its ends have been taken out by the next FindPairs
+    void Remove(uint32_t proxy)
+    {
+        if(proxy >= proxies.size() || !proxies[proxy].alive) return;
+        proxies[proxy].collider->_sweepProxy = SpatialIndex::NoProxy;
+        proxies[proxy].collider->_sweep = nullptr;
+        removedIDs.push_back(proxies[proxy].collider->_id);
+        proxies[proxy].alive = false;
+        proxies[proxy].collider = nullptr;
+        removedProxies.push_back(proxy);
+        count--;
+    }
+
+    // takes out every proxy that hasn't been added or updated since the last call, for colliders that are no longer near anything being stepped
+    void RemoveUntouched()
+    {
+        for(uint32_t i = 0; i < proxies.size(); i++)
+        {
+            if(!proxies[i].alive) continue;
+            if(!proxies[i].touched) Remove(i);
+            proxies[i].touched = false;
+        }
+    }
+
+    // every pair whose bounds overlap, at most one of them static, each reported once
+    const std::vector<Pair>& FindPairs()
+    {
+        if(!removedProxies.empty())
+        {
+            // removing keeps the order, but the added ends at the back have to be counted again
+            auto end = std::remove_if(endpoints.begin(), endpoints.begin() + sorted, [this](const Endpoint &e) { return !proxies[e.proxy].alive; });
+            auto added = std::remove_if(endpoints.begin() + sorted, endpoints.end(), [this](const Endpoint &e) { return !proxies[e.proxy].alive; });
+            size_t kept = end - endpoints.begin();
+            std::move(endpoints.begin() + sorted, added, end);
+            endpoints.resize(kept + (added - (endpoints.begin() + sorted)));
+            sorted = kept;
+            freeProxies.insert(freeProxies.end(), removedProxies.begin(), removedProxies.end());
+            removedProxies.clear();
+        }
+        // everything the sweep needs is copied onto the ends, so it only has to walk them in order
+        for(Endpoint &e : endpoints)
+        {
+            const AABB &b = extents[e.proxy];
+            e.value = e.isMax ? b.center.x + b.halfDimension.x : b.center.x - b.halfDimension.x;
+            e.minY = b.center.y - b.halfDimension.y;
+            e.maxY = b.center.y + b.halfDimension.y;
+            e.isStatic = proxies[e.proxy].isStatic;
+        }
+        // insertion sort, almost nothing moves past anything else from one tick to the next
+        for(size_t i = 1; i < sorted; i++)
+        {
+            if(!before(endpoints[i], endpoints[i - 1])) continue;
+            Endpoint e = endpoints[i];
+            size_t j = i;
+            while(j > 0 && before(e, endpoints[j - 1]))
+            {
+                endpoints[j] = endpoints[j - 1];
+                j--;
+            }
+            endpoints[j] = e;
+        }
+        // ends added since the last sweep are in no particular order, so they're sorted on their own and merged in
+        if(sorted < endpoints.size())
+        {
+            std::sort(endpoints.begin() + sorted, endpoints.end(), before);
+            std::inplace_merge(endpoints.begin(), endpoints.begin() + sorted, endpoints.end(), before);
+            sorted = endpoints.size();
+        }
+
+        pairs.clear();
+        openStatic.clear();
+        openMoving.clear();
+        for(const Endpoint &e : endpoints)
+        {
+            // static ones are kept apart so they never have to be checked against each other
+            OpenList &open = e.isStatic ? openStatic : openMoving;
+            if(e.isMax)
+            {
+                uint32_t slot = openSlots[e.proxy];
+                open.proxy[slot] = open.proxy.back();
+                open.minY[slot] = open.minY.back();
+                open.maxY[slot] = open.maxY.back();
+                openSlots[open.proxy[slot]] = slot;
+                open.proxy.pop_back();
+                open.minY.pop_back();
+                open.maxY.pop_back();
+                continue;
+            }
+            // everything still open overlaps on x, so only y is left to check
+            collect(e, openMoving);
+            if(!e.isStatic) collect(e, openStatic);
+            openSlots[e.proxy] = open.proxy.size();
+            open.proxy.push_back(e.proxy);
+            open.minY.push_back(e.minY);
+            open.maxY.push_back(e.maxY);
+        }
+        return pairs;
+    }
+
+    size_t Count() const
+    {
+        return count;
+    }
+
+    // moves the ids of the colliders taken out since the last call onto the end of ids
+    void TakeRemoved(std::vector<uint32_t> &ids)
+    {
+        ids.insert(ids.end(), removedIDs.begin(), removedIDs.end());
+        removedIDs.clear();
+    }
+
+private:
+    struct Proxy
+    {
+        Collider* collider;
+        bool isStatic;
+        bool alive;
+        // added or updated since the last RemoveUntouched
+        bool touched;
+    };
+
+    struct Endpoint
+    {
+        float value;
+        uint32_t proxy;
+        float minY, maxY;
+        bool isMax;
+        bool isStatic;
+    };
+
+    // the proxies whose min has been passed but not their max, one array per field
+    struct OpenList
+    {
+        std::vector<uint32_t> proxy;
+        std::vector<float> minY, maxY;
+
+        void clear()
+        {
+            proxy.clear();
+            minY.clear();
+            maxY.clear();
+        }
+    };
+
+    void collect(const Endpoint &e, const OpenList &open)
+    {
+        const float *minY = open.minY.data(), *maxY = open.maxY.data();
+        size_t size = open.proxy.size();
+        // most ends overlap nothing, so count first in a loop the compiler can vectorize and only go back for hits
+        uint32_t hits = 0;
+        for(size_t i = 0; i < size; i++)
+        {
+            hits += (minY[i] <= e.maxY) & (e.minY <= maxY[i]);
+        }
+        if(hits == 0) return;
+        for(size_t i = 0; i < size; i++)
+        {
+            if(minY[i] <= e.maxY && e.minY <= maxY[i]) pairs.push_back({proxies[open.proxy[i]].collider, proxies[e.proxy].collider});
+        }
+    }
+
+    // mins go before maxes at the same value so touching bounds still count, like AABB::Intersects
+    static bool before(const Endpoint &a, const Endpoint &b)
+    {
+        return a.value < b.value || (a.value == b.value && !a.isMax && b.isMax);
+    }
+
+    std::vector<Proxy> proxies;
+    // per proxy, apart from the rest so the hot loops stay in cache
+    std::vector<AABB> extents;
+    std::vector<uint32_t> openSlots;
+    std::vector<uint32_t> freeProxies;
+    std::vector<uint32_t> removedProxies;
+    std::vector<uint32_t> removedIDs;
+    std::vector<Endpoint> endpoints;
+    // how many of the endpoints were in order after the last sweep, the rest have been added since
+    size_t sorted = 0;
+    OpenList openStatic;
+    OpenList openMoving;
+    std::vector<Pair> pairs;
+    size_t count = 0;
+};
+
+// pushes bodies apart through their velocities, every contact point is solved in turn a few times over so each one
+// sees the others' impulses. what each point needed is kept for the next tick and applied first, so a stack that was
+// already holding itself up doesn't have to find that again from nothing
+class ContactSolver
+{
+public:
+    // starts a tick, last tick's contacts are kept to warm start from
+    void Begin()
+    {
+        previous.swap(contacts);
+        contacts.clear();
+    }
+
+    // the collision's axis points from b towards a, a body is nullptr for whatever doesn't move
+    void Add(Collider* a, RigidBody* bodyA, Collider* b, RigidBody* bodyB, const Collider::Collision &collision)
+    {
+        Contact contact;
+        contact.normal = collision.Axis;
+        // the same two colliders always make the same key, whichever way round the broad phase found them
+        if(b->_id < a->_id)
+        {
+            std::swap(a, b);
+            std::swap(bodyA, bodyB);
+            contact.normal = {-contact.normal.x, -contact.normal.y};
+        }
+        contact.a = a->_id;
+        contact.b = b->_id;
+        contact.bodyA = bodyA;
+        contact.bodyB = bodyB;
+        Vector2 pivotA = a->_pivot(), pivotB = b->_pivot();
+        contact.count = collision.PointCount;
+        for(int i = 0; i < collision.PointCount; i++)
+        {
+            Point &point = contact.points[i];
+            point.feature = collision.Features[i];
+            point.penetration = collision.Depths[i];
+            point.rA = {collision.Points[i].x - pivotA.x, collision.Points[i].y - pivotA.y};
+            point.rB = {collision.Points[i].x - pivotB.x, collision.Points[i].y - pivotB.y};
+        }
+        contacts.push_back(contact);
+    }
+
+    void Solve(float dt, int iterations)
+    {
+        std::sort(contacts.begin(), contacts.end(), ordered);
+        for(Contact &c : contacts)
+        {
+            c.friction = c.bodyA && c.bodyB ? std::sqrt(c.bodyA->Friction * c.bodyB->Friction) : (c.bodyA ? c.bodyA : c.bodyB)->Friction;
+            float restitution = std::max(c.bodyA ? c.bodyA->Restitution : 0.f, c.bodyB ? c.bodyB->Restitution : 0.f);
+            Vector2 tangent = {-c.normal.y, c.normal.x};
+
+            // last tick's impulses only carry over when the two were touching the same way, through the same edges,
+            // or the impulses from when they fell asleep for bodies that have just woken up
+            const Contact* last = find(previous, c);
+            if(last == nullptr) last = find(resting, c);
+
+            for(int i = 0; i < c.count; i++)
+            {
+                Point &p = c.points[i];
+                p.normalMass = effectiveMass(c, p, c.normal);
+                p.tangentMass = effectiveMass(c, p, tangent);
+                // a little overlap is left alone so resting contacts stay touching from one tick to the next
+                p.pushBias = positionCorrection / dt * std::max(0.f, p.penetration - allowedPenetration);
+                float approach = dot(relativeVelocity(c, p), c.normal);
+                p.bias = approach < -bounceThreshold ? -restitution * approach : 0.f;
+
+                for(int j = 0; last != nullptr && j < last->count; j++)
+                {
+                    if(last->points[j].feature != p.feature) continue;
+                    p.normalImpulse = last->points[j].normalImpulse;
+                    p.tangentImpulse = last->points[j].tangentImpulse;
+                    apply(c, p, {c.normal.x * p.normalImpulse + tangent.x * p.tangentImpulse, c.normal.y * p.normalImpulse + tangent.y * p.tangentImpulse});
+                    break;
+                }
+            }
+
+            if(c.count == 2)
+            {
+                float inverseMass = (c.bodyA ? c.bodyA->_inverseMass() : 0.f) + (c.bodyB ? c.bodyB->_inverseMass() : 0.f);
+                float inertiaA = c.bodyA ? c.bodyA->_inverseInertia : 0.f, inertiaB = c.bodyB ? c.bodyB->_inverseInertia : 0.f;
+                float a1 = cross(c.points[0].rA, c.normal), a2 = cross(c.points[1].rA, c.normal);
+                float b1 = cross(c.points[0].rB, c.normal), b2 = cross(c.points[1].rB, c.normal);
+                c.k11 = inverseMass + inertiaA * a1 * a1 + inertiaB * b1 * b1;
+                c.k22 = inverseMass + inertiaA * a2 * a2 + inertiaB * b2 * b2;
+                c.k12 = inverseMass + inertiaA * a1 * a2 + inertiaB * b1 * b2;
+                // points almost on top of each other, or that nothing can turn about, are left to be solved one at a time
+                c.block = c.k11 * c.k11 < 1000.f * (c.k11 * c.k22 - c.k12 * c.k12);
+            }
+        }
+
+        for(int iteration = 0; iteration < iterations; iteration++)
+        {
+            for(Contact &c : contacts)
+            {
+                Vector2 tangent = {-c.normal.y, c.normal.x};
+                for(int i = 0; i < c.count; i++)
+                {
+                    Point &p = c.points[i];
+                    // friction can't push harder than the point is being held together
+                    float limit = c.friction * p.normalImpulse;
+                    float tangentImpulse = std::max(-limit, std::min(limit, p.tangentImpulse - dot(relativeVelocity(c, p), tangent) * p.tangentMass));
+                    float tangentChange = tangentImpulse - p.tangentImpulse;
+                    p.tangentImpulse = tangentImpulse;
+                    apply(c, p, {tangent.x * tangentChange, tangent.y * tangentChange});
+                }
+                if(c.block)
+                {
+                    float impulse[2] = {c.points[0].normalImpulse, c.points[1].normalImpulse};
+                    float speed[2] = {dot(relativeVelocity(c, c.points[0]), c.normal), dot(relativeVelocity(c, c.points[1]), c.normal)};
+                    float bias[2] = {c.points[0].bias, c.points[1].bias};
+                    if(!solveBoth(c, impulse, speed, bias)) continue;
+                    for(int i = 0; i < 2; i++)
+                    {
+                        float normalChange = impulse[i] - c.points[i].normalImpulse;
+                        c.points[i].normalImpulse = impulse[i];
+                        apply(c, c.points[i], {c.normal.x * normalChange, c.normal.y * normalChange});
+                    }
+                    continue;
+                }
+                for(int i = 0; i < c.count; i++)
+                {
+                    Point &p = c.points[i];
+                    // contacts only push, so the total is never allowed below zero
+                    float normalImpulse = std::max(0.f, p.normalImpulse + (p.bias - dot(relativeVelocity(c, p), c.normal)) * p.normalMass);
+                    float normalChange = normalImpulse - p.normalImpulse;
+                    p.normalImpulse = normalImpulse;
+                    apply(c, p, {c.normal.x * normalChange, c.normal.y * normalChange});
+                }
+            }
+        }
+
+        // overlaps are pushed apart separately, so correcting them never adds speed the bodies keep afterwards
+        for(int iteration = 0; iteration < iterations; iteration++)
+        {
+            for(Contact &c : contacts)
+            {
+                if(c.block)
+                {
+                    float impulse[2] = {c.points[0].pushImpulse, c.points[1].pushImpulse};
+                    float speed[2] = {pushVelocity(c, c.points[0]), pushVelocity(c, c.points[1])};
+                    float bias[2] = {c.points[0].pushBias, c.points[1].pushBias};
+                    if(!solveBoth(c, impulse, speed, bias)) continue;
+                    for(int i = 0; i < 2; i++)
+                    {
+                        float pushChange = impulse[i] - c.points[i].pushImpulse;
+                        c.points[i].pushImpulse = impulse[i];
+                        push(c, c.points[i], pushChange);
+                    }
+                    continue;
+                }
+                for(int i = 0; i < c.count; i++)
+                {
+                    Point &p = c.points[i];
+                    float pushImpulse = std::max(0.f, p.pushImpulse + (p.pushBias - pushVelocity(c, p)) * p.normalMass);
+                    float pushChange = pushImpulse - p.pushImpulse;
+                    p.pushImpulse = pushImpulse;
+                    push(c, p, pushChange);
+                }
+            }
+        }
+    }
+
+    // this tick's contacts where everything that moves has fallen asleep are kept with what they needed, so a pile that
+    // gets woken doesn't have to find that again from nothing
+    void Sleep()
+    {
+        size_t kept = resting.size();
+        for(Contact &c : contacts)
+        {
+            if((c.bodyA != nullptr && !c.bodyA->_sleeping) || (c.bodyB != nullptr && !c.bodyB->_sleeping)) continue;
+            if(c.bodyA != nullptr) c.bodyA->_resting = true;
+            if(c.bodyB != nullptr) c.bodyB->_resting = true;
+            c.bodyA = c.bodyB = nullptr;
+            resting.push_back(c);
+        }
+        if(resting.size() > kept) std::sort(resting.begin(), resting.end(), ordered);
+    }
+
+    // drops what was kept for the colliders with these ids, once they've woken up or gone, and empties the list
+    void Forget(std::vector<uint32_t> &ids)
+    {
+        if(ids.empty()) return;
+        std::sort(ids.begin(), ids.end());
+        auto forgotten = [&ids](const Contact &c) { return std::binary_search(ids.begin(), ids.end(), c.a) || std::binary_search(ids.begin(), ids.end(), c.b); };
+        resting.erase(std::remove_if(resting.begin(), resting.end(), forgotten), resting.end());
+        ids.clear();
+    }
+
+    size_t Count() const
+    {
+        return contacts.size();
+    }
+
+    // how much of the overlap past allowedPenetration is pushed out each tick
+    float positionCorrection = 0.2f;
+    float allowedPenetration = 0.5f;
+    // contacts closing slower than this, in pixels per second, don't bounce
+    float bounceThreshold = 30.f;
+    // last tick's impulses are only reused while the normal has turned less than this far, as a cosine
+    float warmStartAlignment = 0.95f;
+
+private:
+    struct Point
+    {
+        // where the point is from each collider's pivot
+        Vector2 rA, rB;
+        uint32_t feature = 0;
+        float penetration = 0;
+        float normalMass = 0;
+        float tangentMass = 0;
+        // the speed the point should bounce apart at
+        float bias = 0;
+        float normalImpulse = 0;
+        float tangentImpulse = 0;
+        // the speed the overlap should be pushed out at, only ever moves the bodies for this tick
+        float pushBias = 0;
+        float pushImpulse = 0;
+    };
+
+    struct Contact
+    {
+        // the colliders' ids, a always the lower
+        uint32_t a;
+        uint32_t b;
+        RigidBody* bodyA;
+        RigidBody* bodyB;
+        Vector2 normal;
+        float friction = 0;
+        int count = 0;
+        Point points[2];
+        // how each point's speed along the normal changes with an impulse at either point, for solving two at once
+        float k11 = 0, k12 = 0, k22 = 0;
+        bool block = false;
+    };
+
+    static bool ordered(const Contact &x, const Contact &y)
+    {
+        return x.a < y.a || (x.a == y.a && x.b < y.b);
+    }
+
+    // the same pair in a sorted list, if they touched the same way there
+    const Contact* find(const std::vector<Contact> &list, const Contact &c) const
+    {
+        auto it = std::lower_bound(list.begin(), list.end(), c, ordered);
+        if(it == list.end() || it->a != c.a || it->b != c.b) return nullptr;
+        return it->normal.x * c.normal.x + it->normal.y * c.normal.y > warmStartAlignment ? &*it : nullptr;
+    }
+
+    // finds the totals for both points of a contact together, so an edge resting flat doesn't rock from one end to the
+    // other the way solving the points in turn does. each point either pushes and ends up at its bias speed, or doesn't
+    // push and is already moving apart at least that fast, and the first of the four ways that works is taken
+    static bool solveBoth(const Contact &c, float (&impulse)[2], const float (&speed)[2], const float (&bias)[2])
+    {
+        // the speeds there would be with nothing pushing
+        float b1 = speed[0] - bias[0] - (c.k11 * impulse[0] + c.k12 * impulse[1]);
+        float b2 = speed[1] - bias[1] - (c.k12 * impulse[0] + c.k22 * impulse[1]);
+        float det = c.k11 * c.k22 - c.k12 * c.k12;
+        float x1 = (c.k12 * b2 - c.k22 * b1) / det;
+        float x2 = (c.k12 * b1 - c.k11 * b2) / det;
+        if(x1 >= 0 && x2 >= 0)
+        {
+            impulse[0] = x1;
+            impulse[1] = x2;
+            return true;
+        }
+        x1 = -b1 / c.k11;
+        if(x1 >= 0 && c.k12 * x1 + b2 >= 0)
+        {
+            impulse[0] = x1;
+            impulse[1] = 0;
+            return true;
+        }
+        x2 = -b2 / c.k22;
+        if(x2 >= 0 && c.k12 * x2 + b1 >= 0)
+        {
+            impulse[0] = 0;
+            impulse[1] = x2;
+            return true;
+        }
+        if(b1 >= 0 && b2 >= 0)
+        {
+            impulse[0] = impulse[1] = 0;
+            return true;
+        }
+        return false;
+    }
+
+    static float dot(Vector2 x, Vector2 y)
+    {
+        return x.x * y.x + x.y * y.y;
+    }
+
+    static float cross(Vector2 x, Vector2 y)
+    {
+        return x.x * y.y - x.y * y.x;
+    }
+
+    // one over how much the point's speed along the direction changes for each unit of impulse along it
+    static float effectiveMass(const Contact &c, const Point &p, Vector2 direction)
+    {
+        float k = 0;
+        if(c.bodyA) k += c.bodyA->_inverseMass() + c.bodyA->_inverseInertia * cross(p.rA, direction) * cross(p.rA, direction);
+        if(c.bodyB) k += c.bodyB->_inverseMass() + c.bodyB->_inverseInertia * cross(p.rB, direction) * cross(p.rB, direction);
+        return k > 0 ? 1.f / k : 0.f;
+    }
+
+    // how fast the point on a moves away from the point on b, turning included
+    static Vector2 relativeVelocity(const Contact &c, const Point &p)
+    {
+        Vector2 velocity = {0, 0};
+        if(c.bodyA)
+        {
+            velocity.x += c.bodyA->Velocity.x - c.bodyA->AngularVelocity * p.rA.y;
+            velocity.y += c.bodyA->Velocity.y + c.bodyA->AngularVelocity * p.rA.x;
+        }
+        if(c.bodyB)
+        {
+            velocity.x -= c.bodyB->Velocity.x - c.bodyB->AngularVelocity * p.rB.y;
+            velocity.y -= c.bodyB->Velocity.y + c.bodyB->AngularVelocity * p.rB.x;
+        }
+        return velocity;
+    }
+
+    static float pushVelocity(const Contact &c, const Point &p)
+    {
+        Vector2 velocity = {0, 0};
+        if(c.bodyA)
+        {
+            velocity.x += c.bodyA->_pushVelocity.x - c.bodyA->_pushAngularVelocity * p.rA.y;
+            velocity.y += c.bodyA->_pushVelocity.y + c.bodyA->_pushAngularVelocity * p.rA.x;
+        }
+        if(c.bodyB)
+        {
+            velocity.x -= c.bodyB->_pushVelocity.x - c.bodyB->_pushAngularVelocity * p.rB.y;
+            velocity.y -= c.bodyB->_pushVelocity.y + c.bodyB->_pushAngularVelocity * p.rB.x;
+        }
+        return dot(velocity, c.normal);
+    }
+
+    static void push(const Contact &c, const Point &p, float impulse)
+    {
+        Vector2 push = {c.normal.x * impulse, c.normal.y * impulse};
+        if(c.bodyA)
+        {
+            c.bodyA->_pushVelocity.x += push.x * c.bodyA->_inverseMass();
+            c.bodyA->_pushVelocity.y += push.y * c.bodyA->_inverseMass();
+            c.bodyA->_pushAngularVelocity += cross(p.rA, push) * c.bodyA->_inverseInertia;
+        }
+        if(c.bodyB)
+        {
+            c.bodyB->_pushVelocity.x -= push.x * c.bodyB->_inverseMass();
+            c.bodyB->_pushVelocity.y -= push.y * c.bodyB->_inverseMass();
+            c.bodyB->_pushAngularVelocity -= cross(p.rB, push) * c.bodyB->_inverseInertia;
+        }
+    }
+
+    // a gets the impulse at the point and b gets it the other way
+    static void apply(const Contact &c, const Point &p, Vector2 impulse)
+    {
+        if(c.bodyA)
+        {
+            c.bodyA->Velocity.x += impulse.x * c.bodyA->_inverseMass();
+            c.bodyA->Velocity.y += impulse.y * c.bodyA->_inverseMass();
+            c.bodyA->AngularVelocity += cross(p.rA, impulse) * c.bodyA->_inverseInertia;
+        }
+        if(c.bodyB)
+        {
+            c.bodyB->Velocity.x -= impulse.x * c.bodyB->_inverseMass();
+            c.bodyB->Velocity.y -= impulse.y * c.bodyB->_inverseMass();
+            c.bodyB->AngularVelocity -= cross(p.rB, impulse) * c.bodyB->_inverseInertia;
+        }
+    }
+
+    std::vector<Contact> contacts;
+    std::vector<Contact> previous;
+    // from sleeping bodies, sorted like the others
+    std::vector<Contact> resting;
+};
+
+// groups the awake bodies that touch each other, through a union find over the tick's contacts. a body can only
+// sleep with everything it is touching, or it would stop holding up whatever it supports
+class Islands
+{
+public:
+    void Begin(const std::vector<RigidBody*> &bodies)
+    {
+        parents.resize(bodies.size());
+        for(uint32_t i = 0; i < bodies.size(); i++)
+        {
+            parents[i] = i;
+            bodies[i]->_island = i;
+        }
+    }
+
+    // leaves every body out of the islands until the next Begin
+    void End(const std::vector<RigidBody*> &bodies)
+    {
+        for(uint32_t i = 0; i < bodies.size(); i++)
+        {
+            bodies[i]->_island = RigidBody::NoIsland;
+        }
+    }
+
+    void Link(RigidBody* a, RigidBody* b)
+    {
+        uint32_t rootA = find(a->_island), rootB = find(b->_island);
+        if(rootA != rootB) parents[rootA] = rootB;
+    }
+
+    // bodies build up rest time while they're slow, an island goes to sleep once its least rested body has had long enough
+    void Sleep(const std::vector<RigidBody*> &bodies, float dt, float velocity, float angularVelocity, float time)
+    {
+        rest.assign(bodies.size(), std::numeric_limits<float>::max());
+        for(uint32_t i = 0; i < bodies.size(); i++)
+        {
+            RigidBody* body = bodies[i];
+            float speed = body->Velocity.x * body->Velocity.x + body->Velocity.y * body->Velocity.y;
+            if(!body->CanSleep || speed > velocity * velocity || std::abs(body->AngularVelocity) > angularVelocity) body->_restTime = 0;
+            else body->_restTime += dt;
+            uint32_t root = find(i);
+            rest[root] = std::min(rest[root], body->_restTime);
+        }
+        for(uint32_t i = 0; i < bodies.size(); i++)
+        {
+            if(rest[find(i)] >= time) bodies[i]->_sleep();
+        }
+    }
+
+private:
+    uint32_t find(uint32_t i)
+    {
+        while(parents[i] != i)
+        {
+            parents[i] = parents[parents[i]];
+            i = parents[i];
+        }
+        return i;
+    }
+
+    std::vector<uint32_t> parents;
+    std::vector<float> rest;
+};
+
+class BaseUIComponent : public Drawable
+{
+public:
+    BaseUIComponent() : Drawable() {}
+
+    // position defined by a percentage of the screen size
+    Vector2 percentPosition;
+    // scale defined by a percentage of the screen size
+    Vector2 percentScale;
+};
+
+class UIPanel : public BaseUIComponent
+{
+public:
+    UIPanel() : BaseUIComponent() {}
+
+    enum PanelMode
+    {
+        ColourPanel, SpritePanel
+    };
+
+    void _render(RenderBatch* batch, sf::RenderWindow* window) override
+    {
+        Vector2 wSize = {window->getSize()};
+
+        if(mode == ColourPanel)
+        {
+            Vector2 pos = {wSize.x * percentPosition.x, wSize.y * percentPosition.y};
+            Vector2 camPos = camera->getCenter();
+            pos.x += camPos.x;
+            pos.y += camPos.y;
+            Vector2 scale = {wSize.x * percentScale.x, wSize.y * percentScale.y};
+            rect.setPosition(pos.x, pos.y);
+            rect.setSize({scale.x, scale.y});
+            rect.setFillColor(colour);
+            rect.setOutlineColor(colour);
+            window->draw(rect);
+            return;
+        }
+        int page;
+        Vector2 spritePos, spriteSize;
+        if(!_locate(sprite, page, spritePos, spriteSize))
+        {
+            return;
+        }
+        Vector2 sprScale = {wSize.x * percentScale.x, wSize.y * percentScale.y};
+        Vector2 sprPos = {wSize.x * (percentPosition.x - percentScale.x * 0.5f), wSize.y * (percentPosition.y - percentScale.y * 0.5f)};
+        Vector2 camPos = camera->getCenter();
+        sprPos.x += camPos.x;
+        sprPos.y += camPos.y;
+        sf::Vertex* quad = batch->AddQuad(page);
+        quad[0].position = {sprPos.x, sprPos.y};
+        quad[1].position = {sprPos.x + sprScale.x, sprPos.y};
+        quad[2].position = {sprPos.x + sprScale.x, sprPos.y + sprScale.y};
+        quad[3].position = {sprPos.x, sprPos.y + sprScale.y};
+        quad[0].texCoords = {spritePos.x, spritePos.y};
+        quad[1].texCoords = {spritePos.x + spriteSize.x, spritePos.y};
+        quad[2].texCoords = {spritePos.x + spriteSize.x, spritePos.y + spriteSize.y};
+        quad[3].texCoords = {spritePos.x, spritePos.y + spriteSize.y};
+    }
+
+    PanelMode mode = ColourPanel;
+    sf::Color colour;
+    Sprite sprite;
+
+private:
+    sf::RectangleShape rect;
+};
+
+class TextRenderer : public BaseUIComponent
+{
+public:
+    TextRenderer(String fontPath = "fonts/default.ttf") : BaseUIComponent()
+    {
+        if(!font.loadFromFile(fontPath))
+        {
+            std::cout << "Error: Invalid font" << std::endl;
+            exit(-1);
+        }
+    }
+
+    void _render(RenderBatch* batch, sf::RenderWindow* window) override
+    {
+        if(shownText != this->text)
+        {
+            shownText = this->text;
+            label.setString(shownText);
+        }
+        label.setCharacterSize(fontSize);
+        Vector2 wSize = {window->getSize()};
+        Vector2 pos = {wSize.x * percentPosition.x, wSize.y * percentPosition.y};
+        Vector2 camPos = camera->getCenter();
+        pos.x += camPos.x;
+        pos.y += camPos.y;
+        label.setPosition(pos.x, pos.y);
+        label.setFont(font);
+        label.setColor(colour);
+        if(centred)
+        {
+            float w = label.getLocalBounds().width;
+            float h = label.getLocalBounds().height;
+            label.setOrigin(w / 2.f, h / 2.f);
+        }
+        else
+        {
+            label.setOrigin(0.f, 0.f);
+        }
+        batch->AddText(&label);
+    }
+
+    bool centred = true;
+    String text;
+    sf::Font font;
+    sf::Color colour;
+    unsigned int fontSize = 14;
+
+private:
+    sf::Text label;
+    String shownText;
+};
+
+class Button : public BaseUIComponent
+{
+public:
+    // use Button(std::bind(&Class::Function, this));
+    Button(std::function<void()> callback) : BaseUIComponent()
+    {
+        this->callback = callback;
+    }
+
+    enum ButtonMode
+    {
+        ColourButton, SpriteButton
+    };
+
+    void _render(RenderBatch* batch, sf::RenderWindow* window) override
+    {
+        wSize = {window->getSize()};
+
+        if(mode == ColourButton)
+        {
+            Vector2 pos = {wSize.x * (percentPosition.x - percentScale.x * 0.5f), wSize.y * (percentPosition.y - percentScale.y * 0.5f)};
+            Vector2 camPos = camera->getCenter();
+            pos.x += camPos.x;
+            pos.y += camPos.y;
+            Vector2 scale = {wSize.x * percentScale.x, wSize.y * percentScale.y};
+            rect.setPosition(pos.x, pos.y);
+            rect.setSize({scale.x, scale.y});
+            rect.setFillColor(colour);
+            rect.setOutlineColor(colour);
+            window->draw(rect);
+            return;
+        }
+        int page;
+        Vector2 spritePos, spriteSize;
+        if(!_locate(sprite, page, spritePos, spriteSize))
+        {
+            return;
+        }
+        Vector2 sprScale = {wSize.x * percentScale.x, wSize.y * percentScale.y};
+        Vector2 sprPos = {wSize.x * (percentPosition.x - percentScale.x * 0.5f), wSize.y * (percentPosition.y - percentScale.y * 0.5f)};
+        Vector2 camPos = camera->getCenter();
+        sprPos.x += camPos.x;
+        sprPos.y += camPos.y;
+        sf::Vertex* quad = batch->AddQuad(page);
+        quad[0].position = {sprPos.x, sprPos.y};
+        quad[1].position = {sprPos.x + sprScale.x, sprPos.y};
+        quad[2].position = {sprPos.x + sprScale.x, sprPos.y + sprScale.y};
+        quad[3].position = {sprPos.x, sprPos.y + sprScale.y};
+        quad[0].texCoords = {spritePos.x, spritePos.y};
+        quad[1].texCoords = {spritePos.x + spriteSize.x, spritePos.y};
+        quad[2].texCoords = {spritePos.x + spriteSize.x, spritePos.y + spriteSize.y};
+        quad[3].texCoords = {spritePos.x, spritePos.y + spriteSize.y};
+    }
+
+    void Update() override
+    {
+        Vector2 mousePos = input->GetMousePos();
+        mousePos.x -= wSize.x / 2.f;
+        mousePos.y -= wSize.y / 2.f;
+        Vector2 position = Vector2(percentPosition.x * wSize.x, percentPosition.y * wSize.y);
+        Vector2 scale = Vector2(percentScale.x * wSize.x / 2.f, percentScale.y * wSize.y / 2.f);
+        bounds = AABB({position, scale});
+        if(bounds.ContainsPoint(mousePos))
+        {
+            if(input->GetButtonDown(button))
+            {
+                (callback)();
+            }
+        }
+    }
+
+    ButtonMode mode = ColourButton;
+    sf::Color colour = sf::Color::White;
+    Sprite sprite;
+    Input::MouseButton button = Input::MouseButton::Left;
+    std::function<void()> callback;
+
+private:
+    Vector2 wSize;
+    AABB bounds;
+    sf::RectangleShape rect;
+};
+
+class Toggle : public BaseUIComponent
+{
+public:
+    Toggle() : BaseUIComponent() {}
+
+    enum ToggleMode
+    {
+        ColourToggle, SpriteToggle
+    };
+
+    void _render(RenderBatch* batch, sf::RenderWindow* window) override
+    {
+        wSize = {window->getSize()};
+
+        if(mode == ColourToggle)
+        {
+            Vector2 pos = {wSize.x * (percentPosition.x - percentScale.x * 0.5f), wSize.y * (percentPosition.y - percentScale.y * 0.5f)};
+            Vector2 camPos = camera->getCenter();
+            pos.x += camPos.x;
+            pos.y += camPos.y;
+            Vector2 scale = {wSize.x * percentScale.x, wSize.y * percentScale.y};
+            rect.setPosition(pos.x, pos.y);
+            rect.setSize({scale.x, scale.y});
+            if(value)
+            {
+                rect.setFillColor(activeColour);
+                rect.setOutlineColor(activeColour);
+            }
+            else
+            {
+                rect.setFillColor(inactiveColour);
+                rect.setOutlineColor(inactiveColour);
+            }
+            window->draw(rect);
+            return;
+        }
+        Sprite sprite;
+        if(value)
+        {
+            sprite = activeSprite;
+        }
+        else
+        {
+            sprite = inactiveSprite;
+        }
+        int page;
+        Vector2 spritePos, spriteSize;
+        if(!_locate(sprite, page, spritePos, spriteSize))
+        {
+            return;
+        }
+        Vector2 sprScale = {wSize.x * percentScale.x, wSize.y * percentScale.y};
+        Vector2 sprPos = {wSize.x * (percentPosition.x - percentScale.x * 0.5f), wSize.y * (percentPosition.y - percentScale.y * 0.5f)};
+        Vector2 camPos = camera->getCenter();
+        sprPos.x += camPos.x;
+        sprPos.y += camPos.y;
+        sf::Vertex* quad = batch->AddQuad(page);
+        quad[0].position = {sprPos.x, sprPos.y};
+        quad[1].position = {sprPos.x + sprScale.x, sprPos.y};
+        quad[2].position = {sprPos.x + sprScale.x, sprPos.y + sprScale.y};
+        quad[3].position = {sprPos.x, sprPos.y + sprScale.y};
+        quad[0].texCoords = {spritePos.x, spritePos.y};
+        quad[1].texCoords = {spritePos.x + spriteSize.x, spritePos.y};
+        quad[2].texCoords = {spritePos.x + spriteSize.x, spritePos.y + spriteSize.y};
+        quad[3].texCoords = {spritePos.x, spritePos.y + spriteSize.y};
+    }
+
+    void Update() override
+    {
+        Vector2 mousePos = input->GetMousePos();
+        mousePos.x -= wSize.x / 2.f;
+        mousePos.y -= wSize.y / 2.f;
+        Vector2 position = Vector2(percentPosition.x * wSize.x, percentPosition.y * wSize.y);
+        Vector2 scale = Vector2(percentScale.x * wSize.x / 2.f, percentScale.y * wSize.y / 2.f);
+        bounds = AABB({position, scale});
+        if(bounds.ContainsPoint(mousePos))
+        {
+            if(input->GetButtonDown(button))
+            {
+                value = !value;
+            }
+        }
+    }
+
+    ToggleMode mode = ColourToggle;
+    sf::Color activeColour = sf::Color::White, inactiveColour = sf::Color(0xFF888888);
+    Sprite activeSprite, inactiveSprite;
+    Input::MouseButton button = Input::MouseButton::Left;
+    bool value;
+
+private:
+    Vector2 wSize;
+    AABB bounds;
+    sf::RectangleShape rect;
+};
+
+class TextField : public BaseUIComponent
+{
+public:
+
+
+    TextField(String fontPath = "fonts/default.ttf") : BaseUIComponent()
+    {
+        if(!font.loadFromFile(fontPath))
+        {
+            std::cout << "Error: Invalid font" << std::endl;
+            exit(-1);
+        }
+    }
+
+    enum FieldMode
+    {
+        ColourField, SpriteField
+    };
+
+    void _render(RenderBatch* batch, sf::RenderWindow* window) override
+    {
+        wSize = {window->getSize()};
+
+        if(mode == ColourField)
+        {
+            Vector2 pos = {wSize.x * (percentPosition.x - percentScale.x * 0.5f), wSize.y * (percentPosition.y - percentScale.y * 0.5f)};
+            Vector2 camPos = camera->getCenter();
+            pos.x += camPos.x;
+            pos.y += camPos.y;
+            Vector2 scale = {wSize.x * percentScale.x, wSize.y * percentScale.y};
+            rect.setPosition(pos.x, pos.y);
+            rect.setSize({scale.x, scale.y});
+            if(selected)
+            {
+                rect.setFillColor(activeColour);
+                rect.setOutlineColor(activeColour);
+            }
+            else
+            {
+                rect.setFillColor(inactiveColour);
+                rect.setOutlineColor(inactiveColour);
+            }
+            window->draw(rect);
+        }
+        else
+        {
+            Sprite sprite;
+            if(selected)
+            {
+                sprite = activeSprite;
+            }
+            else
+            {
+                sprite = inactiveSprite;
+            }
+            int page;
+            Vector2 spritePos, spriteSize;
+            if(_locate(sprite, page, spritePos, spriteSize))
+            {
+                Vector2 sprScale = {wSize.x * percentScale.x, wSize.y * percentScale.y};
+                Vector2 sprPos = {wSize.x * (percentPosition.x - percentScale.x * 0.5f), wSize.y * (percentPosition.y - percentScale.y * 0.5f)};
+                Vector2 camPos = camera->getCenter();
+                sprPos.x += camPos.x;
+                sprPos.y += camPos.y;
+                sf::Vertex* quad = batch->AddQuad(page);
+                quad[0].position = {sprPos.x, sprPos.y};
+                quad[1].position = {sprPos.x + sprScale.x, sprPos.y};
+                quad[2].position = {sprPos.x + sprScale.x, sprPos.y + sprScale.y};
+                quad[3].position = {sprPos.x, sprPos.y + sprScale.y};
+                quad[0].texCoords = {spritePos.x, spritePos.y};
+                quad[1].texCoords = {spritePos.x + spriteSize.x, spritePos.y};
+                quad[2].texCoords = {spritePos.x + spriteSize.x, spritePos.y + spriteSize.y};
+                quad[3].texCoords = {spritePos.x, spritePos.y + spriteSize.y};
+            }
+        }
+        if(shownText != this->value)
+        {
+            shownText = this->value;
+            label.setString(shownText);
+        }
+        label.setCharacterSize(fontSize);
+        Vector2 wSize = {window->getSize()};
+        Vector2 pos = {wSize.x * percentPosition.x, wSize.y * percentPosition.y};
+        label.setPosition(pos.x, pos.y);
+        label.setFont(font);
+        label.setColor(textColour);
+        if(centred)
+        {
+            float w = label.getLocalBounds().width;
+            float h = label.getLocalBounds().height;
+            label.setOrigin(w / 2.f, h / 2.f);
+        }
+        else
+        {
+            label.setOrigin(0.f, 0.f);
+        }
+        batch->AddText(&label);
+    }
+
+    void Update() override
+    {
+        if(dt == dtPrev)
+        {
+            return;
+        }
+        Vector2 mousePos = input->GetMousePos();
+        mousePos.x -= wSize.x / 2.f;
+        mousePos.y -= wSize.y / 2.f;
+        Vector2 position = Vector2(percentPosition.x * wSize.x, percentPosition.y * wSize.y);
+        Vector2 scale = Vector2(percentScale.x * wSize.x / 2.f, percentScale.y * wSize.y / 2.f);
+        bounds = AABB({position, scale});
+        if(bounds.ContainsPoint(mousePos))
+        {
+            selected = true;
+            std::string val = input->GetTextTyped();
+            if(val.size() <= 0)
+            {
+                return;
+                dtPrev = dt;
+            }
+            char c = val.at(0);
+            if(c == '\b')
+            {
+                if(value.size() <= 0)
+                {
+                    dtPrev = dt;
+                    return;
+                }
+                value.pop_back();
+
+                dtPrev = dt;
+                return;
+            }
+            value += c;
+        }
+        else selected = false;
+
+        dtPrev = dt;
+    }
+
+    FieldMode mode = ColourField;
+    sf::Color activeColour = sf::Color::White, inactiveColour = sf::Color(0x888888FF);
+    Sprite activeSprite, inactiveSprite;
+    Input::MouseButton button = Input::MouseButton::Left;
+    bool selected = false;
+    std::string value;
+    bool centred = true;
+    sf::Font font;
+    sf::Color textColour;
+    unsigned int fontSize = 14;
+    float dtPrev;
+
+private:
+    sf::RectangleShape rect;
+    sf::Text label;
+    String shownText;
+    Vector2 wSize;
+    AABB bounds;
 };
 
-class Transform : public Script
+class GameObject
 {
 public:
-    Transform() : Script()
+    GameObject()
     {
-        transform = this;
+        transform = ComponentPool<Transform>::Get().Create();
+        components.push_back(transform);
+        _fillLookup(transform);
+        transform->_setup(camera, time, math, input, audio, textures);
+        transform->self = this;
+    }
 
-        position = {0, 0};
-        scale = {1, 1};
-        rotation = 0;
+    void AddComponent(Script* component)
+    {
+        components.push_back(component);
+        Drawable* drawable = dynamic_cast<Drawable*>(component);
+        if(drawable != nullptr) drawables.push_back(drawable);
+        _fillLookup(component);
+
+        component->app = app;
+        component->_setup(camera, time, math, input, audio, textures);
+        component->self = this;
+        component->transform = transform;
+        if(created) component->OnCreate();
+        if(started) component->Start();
     }
 
-    Vector2 position = {0.f, 0.f};
-    Vector2 scale = {1.f, 1.f};
-    float rotation = 0.f;
-};
+    // pooled components are given back to their pool, so the pointer isn't valid afterwards
+    void RemoveComponent(Script* component)
+    {
+        if(component == nullptr || component == transform) return;
+        auto it = std::find(components.begin(), components.end(), component);
+        if(it == components.end()) return;
+        components.erase(it);
+        Drawable* drawable = dynamic_cast<Drawable*>(component);
+        if(drawable != nullptr) drawables.erase(std::find(drawables.begin(), drawables.end(), drawable));
+        // any type it stood in for falls to the next component of that type
+        for(uint32_t type = 0; type < lookup.size(); type++)
+        {
+            if(lookup[type] == nullptr || lookup[type] != ComponentType::Cast(type, component)) continue;
+            lookup[type] = nullptr;
+            for(size_t i = 0; i < components.size() && lookup[type] == nullptr; i++)
+            {
+                lookup[type] = ComponentType::Cast(type, components[i]);
+            }
+        }
 
-class Drawable : public Script
-{
-public:
-    Drawable() : Script() {}
+        _leaveSweep(component);
+        if(created) component->OnDestroy();
+        if(component->_release != nullptr) component->_release(component);
+    }
 
-    virtual void _render(sf::VertexArray* va, sf::RenderWindow* window, std::vector<sf::Text>* text, std::vector<DebugObj*>* debugDraw) {}
+    // constructs the component in its type's ComponentPool, use AddComponent<SpriteRenderer>(Sprite(0, 0, 16, 16));
+    template <class T, typename... Args>
+    T* AddComponent(Args&&... args)
+    {
+        T* component = ComponentPool<T>::Get().Create(std::forward<Args>(args)...);
+        AddComponent(component);
+        return component;
+    }
 
-    bool lateRender = false;
-    bool debugDrawEnabled = false;
-};
+    template <class T>
+    bool HasComponent()
+    {
+        return _lookup<T>() != nullptr;
+    }
 
-class SpriteRenderer : public Drawable
-{
-public:
-    SpriteRenderer() : Drawable() {}
-    SpriteRenderer(Sprite sprite) : Drawable()
+    template <class T>
+    T* GetComponent()
     {
-        this->sprite = sprite;
+        T* component = _lookup<T>();
+        if(component != nullptr) return component;
+        String str = typeid(T).name();
+        std::cout << "Error: component of type '" << str << "' not found" << std::endl;
+        exit(1);
     }
-    Sprite sprite;
 
-    void _render(sf::VertexArray* va, sf::RenderWindow* window, std::vector<sf::Text>* text, std::vector<DebugObj*>* debugDraw) override
+    void AddObject(GameObject* object)
     {
-        int prevVertices = va->getVertexCount();
-        Vector2 spriteSize = sprite.size;
-        Vector2 spritePos = sprite.pos;
-        Vector2 sprScale = {transform->scale.x * spriteSize.x, transform->scale.y * spriteSize.y};
-        Vector2 sprPos = {transform->position.x - (sprScale.x / 2.f), transform->position.y - (sprScale.y / 2.f)};
-        va->resize(prevVertices + 4);
-        sf::Vertex* quad = &va[0][prevVertices];
-        quad[0].position = {sprPos.x, sprPos.y};
-        quad[1].position = {sprPos.x + sprScale.x, sprPos.y};
-        quad[2].position = {sprPos.x + sprScale.x, sprPos.y + sprScale.y};
-        quad[3].position = {sprPos.x, sprPos.y + sprScale.y};
-        quad[0].texCoords = {spritePos.x, spritePos.y};
-        quad[1].texCoords = {spritePos.x + spriteSize.x, spritePos.y};
-        quad[2].texCoords = {spritePos.x + spriteSize.x, spritePos.y + spriteSize.y};
-        quad[3].texCoords = {spritePos.x, spritePos.y + spriteSize.y};
+        uint32_t id = object->_generateUniqueID(children);
+        children.insert({id, object});
+        object->app = app;
+        object->parent = this;
+        object->_setInScene(_inScene);
+        // the next refresh puts it in the broad phase
+        object->transform->MarkMoved();
+        if(!setup) return;
+        object->_setup(camera, time, math, input, audio, textures);
+        object->_onCreate();
+        object->_start();
+    }
 
-        if(debugDrawEnabled)
+    void RemoveObject(GameObject* object, bool callOnDestroy = true)
+    {
+        if(object == nullptr) return;
+        bool inScene = object->_inScene;
+        object->_indexRemove();
+        object->_setInScene(false);
+        // only the top level object is sure to know the application
+        if(inScene)
         {
-            sf::RectangleShape* rect = new sf::RectangleShape();
-            rect->setPosition(sprPos.x, sprPos.y);
-            rect->setSize({sprPos.x + sprScale.x, sprPos.y + sprScale.y});
-            DebugObj* obj = new DebugObj();
-            obj->rect = rect;
-            debugDraw->push_back(obj);
+            GameObject* root = this;
+            while(root->parent != nullptr) root = root->parent;
+            _forgetSimulated(root->app);
         }
+        if(callOnDestroy) object->_onDestroy();
+        children.erase(object->id);
     }
-};
 
-class Collider : public Script
-{
-public:
-    struct Collision
+    // use this rather than setting enabled from outside the object's own scripts, so the broad phase hears about it
+    void SetEnabled(bool enabled)
     {
-        Collision(Collider* c1, Collider* c2, bool collision)
+        this->enabled = enabled;
+        transform->MarkMoved();
+    }
+
+    void Destroy(bool callOnDestroy = true)
+    {
+        parent->RemoveObject(this, callOnDestroy);
+    }
+
+    void _onCreate()
+    {
+        if(!created)
+        created = true;
+        for(int i = 0; i < components.size(); i++)
         {
-            HasCollision = collision;
-            this->c1 = c1;
-            this->c2 = c2;
+            components[i]->OnCreate();
         }
+    }
 
-        Collision(Collider* c1, Collider* c2, float overlap, Vector2 axis)
+    void _onDestroy()
+    {
+        for(int i = 0; i < components.size(); i++)
         {
-            Overlap = overlap;
-            if(overlap > 0) HasCollision = true;
-            Axis = axis;
-            this->c1 = c1;
-            this->c2 = c2;
+            components[i]->OnDestroy();
         }
+        auto it = children.begin();
+        while(it != children.end())
+        {
+            children[it->first]->_onDestroy();
+            it++;
+        }
+        for(size_t i = 0; i < drawables.size(); i++)
+        {
+            drawables[i]->_onHidden();
+        }
+        for(size_t i = 0; i < components.size(); i++)
+        {
+            _leaveSweep(components[i]);
+            if(components[i]->_release != nullptr) components[i]->_release(components[i]);
+        }
+        components.clear();
+        drawables.clear();
+        lookup.clear();
+    }
 
-        Collider* c1;
-        Collider* c2;
-        bool HasCollision = false;
-        float Overlap = 0.0f;
-        Vector2 Axis = {0, 0};
-    };
-
-    enum ColliderType
+    // a collider that is going away takes its proxy out of the sweep, so the proxy can't be reused while it still points at it
+    static void _leaveSweep(Script* component)
     {
-        Poly, Circle
-    };
+        Collider* collider = dynamic_cast<Collider*>(component);
+        if(collider != nullptr && collider->_sweep != nullptr) collider->_sweep->Remove(collider->_sweepProxy);
+    }
 
-    Collider() : Script()
+    void _start()
     {
-        
+        if(!started)
+        started = true;
+        for(int i = 0; i < components.size(); i++)
+        {
+            components[i]->Start();
+        }
     }
 
-    void _resolve(Collider* other)
+    void _update()
     {
-        if(other == this) return;
-        Collision collision = resolve(other);
-        if(!collision.HasCollision)
+        if(!enabled)
         {
             return;
         }
-        IsColliding = true;
-        other->IsColliding = true;
-        if(_isStatic && other->_isStatic) return;
-
-        
-        if(_isStatic)
+        for(int i = 0; i < components.size(); i++)
         {
-            other->transform->position.x -= collision.Axis.x * collision.Overlap;
-            other->transform->position.y -= collision.Axis.y * collision.Overlap;
-            return;
+            components[i]->simulated = simulated;
+            components[i]->dt = dt;
+            components[i]->Update();
+        }
+        auto it = children.begin();
+        while(it != children.end())
+        {
+            children[it->first]->simulated = simulated;
+            children[it->first]->dt = dt;
+            children[it->first]->_update();
+            it++;
         }
+    }
 
-        if(other->_isStatic)
+    void _lateUpdate()
+    {
+        if(!enabled)
         {
-            transform->position.x += collision.Axis.x * collision.Overlap;
-            transform->position.y += collision.Axis.y * collision.Overlap;
             return;
         }
-
-        other->transform->position.x -= collision.Axis.x * collision.Overlap * 0.5f;
-        other->transform->position.y -= collision.Axis.y * collision.Overlap * 0.5f;
-        transform->position.x += collision.Axis.x * collision.Overlap * 0.5f;
-        transform->position.y += collision.Axis.y * collision.Overlap * 0.5f;
-        
-        return;
+        for(size_t i = 0; i < components.size(); i++)
+        {
+            components[i]->LateUpdate();
+        }
+        auto it = children.begin();
+        while(it != children.end())
+        {
+            children[it->first]->_lateUpdate();
+            it++;
+        }
     }
 
-    Vector2 Centre;
-    Vector2 Scale = {1, 1};
-    // only applicable for polys
-    AABB bounds;
-    float Rotation;
-    // only applicable to circles
-    float Radius;
-    ColliderType Type;
-    // only applicable to polys
-    std::vector<Vector2> Vertices;
-    // don't change this, you will break the collision system
-    bool _isStatic = true;
-    bool IsColliding = false;
-
-    std::vector<Vector2> offsetAxesDebug;
-    std::vector<float> offsetDstDebug;
-    std::vector<Vector2> intersectionsDebug;
-    std::vector<GameObject*> checkedObjectsDebug;
-    // this will enable the offsetAxesDebug, offsetDstDebug, intersectionsDebug and checkedObjectsDebug vectors, which must be manually cleared each frame to prevent a memory leak
-    bool debugInfoEnabled = false;
-
-private:
-    Collision resolve(Collider* other)
+    // true if every script on the object and its children can be updated on a worker thread
+    bool _threadSafe()
     {
-        if(debugInfoEnabled) checkedObjectsDebug.push_back(other->self);
-        Vector2 v1 = {Centre.x + transform->position.x, Centre.y + transform->position.y};
-        Vector2 v2 = {other->Centre.x + other->transform->position.x, other->Centre.y + other->transform->position.y};
-
-        if(Type == Circle && other->Type == Circle)
+        for(size_t i = 0; i < components.size(); i++)
         {
-            float f1 = Radius;
-            float f2 = other->Radius;
-            float minDst = f1 + f2;
-
-            Vector2 delta = {v1.x - v2.x, v1.y - v2.y};
-            float dst = delta.Mag();
-
-            if(debugInfoEnabled && dst != 0)
-            {
-                Vector2 debugAxis;
-                debugAxis.x = delta.x / dst;
-                debugAxis.y = delta.y / dst;
-                offsetAxesDebug.push_back(debugAxis);
-                offsetDstDebug.push_back(dst);
-            }
-
-            if(dst < minDst && dst != 0)
-            {
-                Vector2 axis;
-                axis.x = delta.x / dst;
-                axis.y = delta.y / dst;
-
-                if(debugInfoEnabled) intersectionsDebug.push_back({(axis.x * -Radius) + v1.x, (axis.y * -Radius) + v1.y});
-
-                return {this, other, (minDst - dst) + 1.f, axis};
-            }
-
-            return {this, other, false};
+            if(!components[i]->threadSafe) return false;
+        }
+        auto it = children.begin();
+        while(it != children.end())
+        {
+            if(!children[it->first]->_threadSafe()) return false;
+            it++;
         }
+        return true;
+    }
+
+    void _setup(sf::View* camera, Time* time, Math* math, Input* input, Audio* audio, TextureManager* textures)
+    {
+        if(setup) return;
+        setup = true;
+        this->camera = camera;
+        this->time = time;
+        this->math = math;
+        this->input = input;
+        this->audio = audio;
+        this->textures = textures;
 
-        if(Type == Poly && other->Type == Circle)
+        for(int i = 0; i < components.size(); i++)
         {
-            return circleVsPoly(v2, other->Radius, v1, Vertices, other);
+            components[i]->_setup(camera, time, math, input, audio, textures);
+            components[i]->OnCreate();
         }
+    }
 
-        if(Type == Circle && other->Type == Poly)
+    // the area the object covers in the broad phase
+    AABB _bounds()
+    {
+        Vector2 halfDim;
+        if(HasComponent<SpriteRenderer>()) halfDim = GetComponent<SpriteRenderer>()->_size();
+        else halfDim = {1, 1};
+        halfDim.x /= 2.f;
+        halfDim.y /= 2.f;
+        halfDim = {halfDim.x * transform->scale.x, halfDim.y * transform->scale.y};
+        // sprites are drawn turned by the rotation, so the box has to fit around the turned sprite
+        if(transform->rotation != 0)
         {
-            return circleVsPoly(v1, Radius, v2, other->Vertices, other);
+            float angle = transform->rotation * 3.14159265f / 180.f;
+            float c = std::abs(std::cos(angle)), s = std::abs(std::sin(angle));
+            halfDim = {std::abs(halfDim.x) * c + std::abs(halfDim.y) * s, std::abs(halfDim.x) * s + std::abs(halfDim.y) * c};
         }
+        return AABB(transform->position, halfDim);
     }
 
-    Collision circleVsPoly(Vector2 circlePos, float radius, Vector2 polyPos, std::vector<Vector2> polygon, Collider* other)
+    // adds the object and its enabled children to the broad phase
+    void _index(SpatialIndex* index)
     {
-        std::vector<Vector2> points1;
-        std::vector<Vector2> points2;
-
-        // setup lines and points
-        for(int i = 0; i < polygon.size(); i++)
+        if(!enabled)
         {
-            Vector2 v1 = polygon[i];
-            Vector2 v2;
-            if(i == polygon.size() - 1) v2 = polygon[0];
-            else v2 = polygon[i + 1];
-            points1.push_back({v1.x + polyPos.x, v1.y + polyPos.y});
-            points2.push_back({v2.x + polyPos.x, v2.y + polyPos.y});
+            return;
         }
-
-        Collision closest = {this, other, -0xFFFFFFFF, {0, 0}};
-
-        for(int i = 0; i < points1.size(); i++)
+        if(_indexProxy == SpatialIndex::NoProxy)
         {
-            float lineX1 = points2[i].x - points1[i].x;
-            float lineY1 = points2[i].y - points1[i].y;
-
-            float lineX2 = circlePos.x - points1[i].x;
-            float lineY2 = circlePos.y - points1[i].y;
-
-            float edgeLength = lineX1 * lineX1 + lineY1 * lineY1;
-
-            float t = std::max(0.f, std::min(edgeLength, (lineX1 * lineX2 + lineY1 * lineY2))) / edgeLength;
-
-            float closestX = points1[i].x + t * lineX1;
-            float closestY = points1[i].y + t * lineY1;
-
-            Vector2 delta;
-            delta.x = circlePos.x - closestX;
-            delta.y = circlePos.y - closestY;
-            float distance = delta.Mag();
-            delta.x /= distance;
-            delta.y /= distance;
-
-            if(debugInfoEnabled)
-            {
-                offsetAxesDebug.push_back(delta);
-                offsetDstDebug.push_back(distance);
-            }
-
-            if(other->debugInfoEnabled)
-            {
-                other->offsetAxesDebug.push_back(delta);
-                other->offsetDstDebug.push_back(-distance);
-            }
-
-            if(distance < radius)
-            {
-                if(debugInfoEnabled) intersectionsDebug.push_back({closestX, closestY});
-                if(other->debugInfoEnabled) other->intersectionsDebug.push_back({closestX, closestY});
-
-                if((radius - distance) + 1.f > closest.Overlap)
-                {
-                    closest.Overlap = (radius - distance) + 1.f;
-                    closest.Axis = delta;
-                }
-            }
+            _spatialIndex = index;
+            _indexProxy = index->add(this, _bounds());
+            _indexVersion = transform->GetVersion();
         }
-        if(closest.Overlap <= 0)
+        auto it = children.begin();
+        while(it != children.end())
         {
-            return {this, other, false};
+            children[it->first]->_index(index);
+            it++;
         }
-        return closest;
     }
-};
-
-// This will not work if there is not already a collider when OnCreate() is called
-class RigidBody : public Script
-{
-public:
-    RigidBody() : Script() {}
 
-    void OnCreate() override
+    void _indexUpdate()
     {
-        if(!HasComponent<Collider>())
+        _indexVersion = transform->GetVersion();
+        _spatialIndex->Update(_indexProxy, _bounds());
+        for(size_t i = 0; i < drawables.size(); i++)
         {
-            std::cout << "Error: RigidBody has no collider\n";
-            exit(1);
+            drawables[i]->_onTransformChanged();
         }
-        collider = GetComponent<Collider>();
-        collider->_isStatic = false;
     }
 
-    void OnDestroy() override
+    void _indexRemove()
     {
-        collider->_isStatic = true;
+        if(_indexProxy != SpatialIndex::NoProxy)
+        {
+            _spatialIndex->remove(_indexProxy);
+            _indexProxy = SpatialIndex::NoProxy;
+        }
+        for(size_t i = 0; i < drawables.size(); i++)
+        {
+            drawables[i]->_onHidden();
+        }
+        auto it = children.begin();
+        while(it != children.end())
+        {
+            children[it->first]->_indexRemove();
+            it++;
+        }
     }
 
-    void _checkCollisions(std::vector<Collider*> others)
+    // compares every transform against where it was last marked, then only reindexes the ones marked moved since the last refresh
+    static void _refreshIndex(SpatialIndex* index)
     {
-        for(int i = 0; i < others.size(); i++)
+        std::vector<Transform*>& moved = Transform::_moved();
+        for(size_t i = 0; i < moved.size(); i++)
         {
-            collider->_resolve(others[i]);
+            Transform* transform = moved[i];
+            transform->_clearMarked();
+            GameObject* object = transform->self;
+            if(!object->_inScene) continue;
+            bool indexed = object->_indexProxy != SpatialIndex::NoProxy;
+            // a parent is only indexed while it and everything above it is enabled
+            bool active = object->enabled && (object->parent == nullptr || object->parent->_indexProxy != SpatialIndex::NoProxy);
+            if(active && !indexed) object->_index(index);
+            else if(!active && indexed) object->_indexRemove();
+            else if(active && transform->GetVersion() != object->_indexVersion) object->_indexUpdate();
         }
+        moved.clear();
     }
 
-    Collider* collider;
-};
-
-class BaseUIComponent : public Drawable
-{
-public:
-    BaseUIComponent() : Drawable() {}
-
-    // position defined by a percentage of the screen size
-    Vector2 percentPosition;
-    // scale defined by a percentage of the screen size
-    Vector2 percentScale;
-};
-
-class UIPanel : public BaseUIComponent
-{
-public:
-    UIPanel() : BaseUIComponent() {}
-
-    enum PanelMode
-    {
-        ColourPanel, SpritePanel
-    };
-
-    void _render(sf::VertexArray* va, sf::RenderWindow* window, std::vector<sf::Text>* text, std::vector<DebugObj*>* debugDraw) override
+    // marks the transforms of the object and its children that its scripts moved, or that were disabled, for the next refresh
+    void _detectMoves()
     {
-        Vector2 wSize = {window->getSize()};
-
-        if(mode == ColourPanel)
+        if(!enabled)
         {
-            sf::RectangleShape rect;
-            Vector2 pos = {wSize.x * percentPosition.x, wSize.y * percentPosition.y};
-            Vector2 camPos = camera->getCenter();
-            pos.x += camPos.x;
-            pos.y += camPos.y;
-            Vector2 scale = {wSize.x * percentScale.x, wSize.y * percentScale.y};
-            rect.setPosition(pos.x, pos.y);
-            rect.setSize({scale.x, scale.y});
-            rect.setFillColor(colour);
-            rect.setOutlineColor(colour);
-            window->draw(rect);
+            if(_indexProxy != SpatialIndex::NoProxy) transform->MarkMoved();
             return;
         }
-        int prevVertices = va->getVertexCount();
-        Vector2 spriteSize = sprite.size;
-        Vector2 spritePos = sprite.pos;
-        Vector2 sprScale = {wSize.x * percentScale.x, wSize.y * percentScale.y};
-        Vector2 sprPos = {wSize.x * (percentPosition.x - percentScale.x * 0.5f), wSize.y * (percentPosition.y - percentScale.y * 0.5f)};
-        Vector2 camPos = camera->getCenter();
-        sprPos.x += camPos.x;
-        sprPos.y += camPos.y;
-        va->resize(prevVertices + 4);
-        sf::Vertex* quad = &va[0][prevVertices];
-        quad[0].position = {sprPos.x, sprPos.y};
-        quad[1].position = {sprPos.x + sprScale.x, sprPos.y};
-        quad[2].position = {sprPos.x + sprScale.x, sprPos.y + sprScale.y};
-        quad[3].position = {sprPos.x, sprPos.y + sprScale.y};
-        quad[0].texCoords = {spritePos.x, spritePos.y};
-        quad[1].texCoords = {spritePos.x + spriteSize.x, spritePos.y};
-        quad[2].texCoords = {spritePos.x + spriteSize.x, spritePos.y + spriteSize.y};
-        quad[3].texCoords = {spritePos.x, spritePos.y + spriteSize.y};
+        transform->_detectMove();
+        auto it = children.begin();
+        while(it != children.end())
+        {
+            children[it->first]->_detectMoves();
+            it++;
+        }
     }
 
-    PanelMode mode = ColourPanel;
-    sf::Color colour;
-    Sprite sprite;
-};
-
-class TextRenderer : public BaseUIComponent
-{
-public:
-    TextRenderer(String fontPath = "fonts/default.ttf") : BaseUIComponent()
+    void _setInScene(bool inScene)
     {
-        if(!font.loadFromFile(fontPath))
+        _inScene = inScene;
+        auto it = children.begin();
+        while(it != children.end())
         {
-            std::cout << "Error: Invalid font" << std::endl;
-            exit(-1);
+            children[it->first]->_setInScene(inScene);
+            it++;
         }
     }
 
-    void _render(sf::VertexArray* va, sf::RenderWindow* window, std::vector<sf::Text>* text, std::vector<DebugObj*>* debugDraw) override
+    void _render(RenderBatch* batch, sf::RenderWindow* window)
     {
-        sf::Text text1;
-        text1.setCharacterSize(fontSize);
-        text1.setString(this->text);
-        Vector2 wSize = {window->getSize()};
-        Vector2 pos = {wSize.x * percentPosition.x, wSize.y * percentPosition.y};
-        Vector2 camPos = camera->getCenter();
-        pos.x += camPos.x;
-        pos.y += camPos.y;
-        text1.setPosition(pos.x, pos.y);
-        text1.setFont(font);
-        text1.setColor(colour);
-        if(centred)
+        if(!enabled)
+        {
+            return;
+        }
+        for(size_t i = 0; i < drawables.size(); i++)
         {
-            float w = text1.getLocalBounds().width;
-            float h = text1.getLocalBounds().height;
-            text1.setOrigin(w / 2.f, h / 2.f);
+            drawables[i]->_render(batch, window);
         }
-        text->push_back(text1);
     }
 
-    bool centred = true;
-    String text;
-    sf::Font font;
-    sf::Color colour;
-    unsigned int fontSize = 14;
-};
-
-class Button : public BaseUIComponent
-{
-public:
-    // use Button(std::bind(&Class::Function, this));
-    Button(std::function<void()> callback) : BaseUIComponent()
+    uint32_t _generateUniqueID(std::map<uint32_t, GameObject*>* objects)
     {
-        this->callback = callback;
+        uint32_t id = std::chrono::system_clock::now().time_since_epoch().count();
+        while(objects->count(id) != 0)
+        {
+            id += 0xe120fc15;
+            uint64_t tmp;
+            tmp = (uint64_t)id * 0x4a39b70d;
+            uint32_t m1 = (tmp >> 32) ^ tmp;
+            tmp = (uint64_t)m1 * 0x12fad5c9;
+            uint32_t m2 = (tmp >> 32) ^ tmp;
+            id = m2;
+        }
+        this->id = id;
+        return id;
     }
 
-    enum ButtonMode
-    {
-        ColourButton, SpriteButton
-    };
+    GameObject* parent = nullptr;
+    Application* app = nullptr;
+    sf::View* camera;
+    Transform* transform;
+    Time* time;
+    Math* math;
+    Input* input;
+    Audio* audio;
+    TextureManager* textures;
+    uint32_t id;
+    float dt;
+    // set by the application's broad phase refresh while the object is inside the simulation distance
+    bool simulated = false;
+    float _timer;
+    bool enabled = true;
+    // broad phase bookkeeping, _indexVersion is the transform version the index last saw
+    SpatialIndex* _spatialIndex = nullptr;
+    uint32_t _indexProxy = SpatialIndex::NoProxy;
+    uint32_t _indexVersion = 0;
+    bool _inScene = false;
 
-    void _render(sf::VertexArray* va, sf::RenderWindow* window, std::vector<sf::Text>* text, std::vector<DebugObj*>* debugDraw) override
+private:
+    // the first component of each type keeps its place in the table
+    void _fillLookup(Script* component)
     {
-        wSize = {window->getSize()};
-
-        if(mode == ColourButton)
+        size_t filled = lookup.size();
+        _growLookup();
+        for(uint32_t type = 0; type < filled; type++)
         {
-            sf::RectangleShape rect;
-            Vector2 pos = {wSize.x * (percentPosition.x - percentScale.x * 0.5f), wSize.y * (percentPosition.y - percentScale.y * 0.5f)};
-            Vector2 camPos = camera->getCenter();
-            pos.x += camPos.x;
-            pos.y += camPos.y;
-            Vector2 scale = {wSize.x * percentScale.x, wSize.y * percentScale.y};
-            rect.setPosition(pos.x, pos.y);
-            rect.setSize({scale.x, scale.y});
-            rect.setFillColor(colour);
-            rect.setOutlineColor(colour);
-            window->draw(rect);
-            return;
+            if(lookup[type] == nullptr) lookup[type] = ComponentType::Cast(type, component);
         }
-        int prevVertices = va->getVertexCount();
-        Vector2 spriteSize = sprite.size;
-        Vector2 spritePos = sprite.pos;
-        Vector2 sprScale = {wSize.x * percentScale.x, wSize.y * percentScale.y};
-        Vector2 sprPos = {wSize.x * (percentPosition.x - percentScale.x * 0.5f), wSize.y * (percentPosition.y - percentScale.y * 0.5f)};
-        Vector2 camPos = camera->getCenter();
-        sprPos.x += camPos.x;
-        sprPos.y += camPos.y;
-        va->resize(prevVertices + 4);
-        sf::Vertex* quad = &va[0][prevVertices];
-        quad[0].position = {sprPos.x, sprPos.y};
-        quad[1].position = {sprPos.x + sprScale.x, sprPos.y};
-        quad[2].position = {sprPos.x + sprScale.x, sprPos.y + sprScale.y};
-        quad[3].position = {sprPos.x, sprPos.y + sprScale.y};
-        quad[0].texCoords = {spritePos.x, spritePos.y};
-        quad[1].texCoords = {spritePos.x + spriteSize.x, spritePos.y};
-        quad[2].texCoords = {spritePos.x + spriteSize.x, spritePos.y + spriteSize.y};
-        quad[3].texCoords = {spritePos.x, spritePos.y + spriteSize.y};
     }
 
-    void Update() override
+    // gives every type registered since the table last grew a slot, filled from all of the components already added
+    void _growLookup()
     {
-        Vector2 mousePos = input->GetMousePos();
-        mousePos.x -= wSize.x / 2.f;
-        mousePos.y -= wSize.y / 2.f;
-        Vector2 position = Vector2(percentPosition.x * wSize.x, percentPosition.y * wSize.y);
-        Vector2 scale = Vector2(percentScale.x * wSize.x / 2.f, percentScale.y * wSize.y / 2.f);
-        bounds = AABB({position, scale});
-        if(bounds.ContainsPoint(mousePos))
+        uint32_t count = ComponentType::Count();
+        uint32_t filled = (uint32_t)lookup.size();
+        if(count == filled) return;
+        lookup.resize(count, nullptr);
+        for(uint32_t type = filled; type < count; type++)
         {
-            if(input->GetButtonDown(button))
+            for(size_t i = 0; i < components.size() && lookup[type] == nullptr; i++)
             {
-                (callback)();
+                lookup[type] = ComponentType::Cast(type, components[i]);
             }
         }
     }
 
-    ButtonMode mode = ColourButton;
-    sf::Color colour = sf::Color::White;
-    Sprite sprite;
-    Input::MouseButton button = Input::MouseButton::Left;
-    std::function<void()> callback;
+    // the table only changes on whichever thread is working on this object, when a component is added or removed or a
+    // type newer than the table is looked up, so scripts on worker threads can use it for their own object
+    template <class T>
+    T* _lookup()
+    {
+        uint32_t type = ComponentType::ID<T>();
+        if(type >= lookup.size()) _growLookup();
+        return static_cast<T*>(lookup[type]);
+    }
 
-private:
-    Vector2 wSize;
-    AABB bounds;
+    std::map<uint32_t, GameObject*> children;
+    std::vector<Script*> components;
+    std::vector<Drawable*> drawables;
+    // indexed by ComponentType id, the first component that is that type
+    std::vector<void*> lookup;
+    bool created = false, started = false, setup = false;
 };
 
-class Toggle : public BaseUIComponent
+// packs values into a buffer a few bits at a time, call Flush once everything is written
+class BitWriter
 {
 public:
-    Toggle() : BaseUIComponent() {}
+    BitWriter(std::vector<uint8_t>& buffer) : buffer(buffer) {}
 
-    enum ToggleMode
+    void Write(uint32_t value, int bits)
     {
-        ColourToggle, SpriteToggle
-    };
+        scratch |= (uint64_t(value) & ((uint64_t(1) << bits) - 1)) << scratchBits;
+        scratchBits += bits;
+        while(scratchBits >= 8)
+        {
+            buffer.push_back(uint8_t(scratch));
+            scratch >>= 8;
+            scratchBits -= 8;
+        }
+    }
+
+    // six bits of length then the value, so small numbers stay small
+    void WriteUnsigned(uint32_t value)
+    {
+        int bits = 0;
+        while(bits < 32 && (value >> bits) != 0) bits++;
+        Write(bits, 6);
+        Write(value, bits);
+    }
+
+    // zigzag encoded so small negative numbers are small too
+    void WriteSigned(int32_t value)
+    {
+        WriteUnsigned((uint32_t(value) << 1) ^ uint32_t(value >> 31));
+    }
+
+    void Flush()
+    {
+        if(scratchBits > 0) buffer.push_back(uint8_t(scratch));
+        scratch = 0;
+        scratchBits = 0;
+    }
+
+private:
+    std::vector<uint8_t>& buffer;
+    uint64_t scratch = 0;
+    int scratchBits = 0;
+};
 
-    void _render(sf::VertexArray* va, sf::RenderWindow* window, std::vector<sf::Text>* text, std::vector<DebugObj*>* debugDraw) override
-    {
-        wSize = {window->getSize()};
+// reads what a BitWriter wrote, reading past the end returns zeros and sets Failed
+class BitReader
+{
+public:
+    BitReader(const std::vector<uint8_t>& buffer) : buffer(buffer) {}
 
-        if(mode == ColourToggle)
+    uint32_t Read(int bits)
+    {
+        while(scratchBits < bits)
         {
-            sf::RectangleShape rect;
-            Vector2 pos = {wSize.x * (percentPosition.x - percentScale.x * 0.5f), wSize.y * (percentPosition.y - percentScale.y * 0.5f)};
-            Vector2 camPos = camera->getCenter();
-            pos.x += camPos.x;
-            pos.y += camPos.y;
-            Vector2 scale = {wSize.x * percentScale.x, wSize.y * percentScale.y};
-            rect.setPosition(pos.x, pos.y);
-            rect.setSize({scale.x, scale.y});
-            if(value)
+            if(position >= buffer.size())
             {
-                rect.setFillColor(activeColour);
-                rect.setOutlineColor(activeColour);
-            }
-            else
-            {
-                rect.setFillColor(inactiveColour);
-                rect.setOutlineColor(inactiveColour);
+                failed = true;
+                return 0;
             }
-            window->draw(rect);
-            return;
-        }
-        int prevVertices = va->getVertexCount();
-        Sprite sprite;
-        if(value)
-        {
-            sprite = activeSprite;
-        }
-        else
-        {
-            sprite = inactiveSprite;
+            scratch |= uint64_t(buffer[position++]) << scratchBits;
+            scratchBits += 8;
         }
-        Vector2 spriteSize = sprite.size;
-        Vector2 spritePos = sprite.pos;
-        Vector2 sprScale = {wSize.x * percentScale.x, wSize.y * percentScale.y};
-        Vector2 sprPos = {wSize.x * (percentPosition.x - percentScale.x * 0.5f), wSize.y * (percentPosition.y - percentScale.y * 0.5f)};
-        Vector2 camPos = camera->getCenter();
-        sprPos.x += camPos.x;
-        sprPos.y += camPos.y;
-        va->resize(prevVertices + 4);
-        sf::Vertex* quad = &va[0][prevVertices];
-        quad[0].position = {sprPos.x, sprPos.y};
-        quad[1].position = {sprPos.x + sprScale.x, sprPos.y};
-        quad[2].position = {sprPos.x + sprScale.x, sprPos.y + sprScale.y};
-        quad[3].position = {sprPos.x, sprPos.y + sprScale.y};
-        quad[0].texCoords = {spritePos.x, spritePos.y};
-        quad[1].texCoords = {spritePos.x + spriteSize.x, spritePos.y};
-        quad[2].texCoords = {spritePos.x + spriteSize.x, spritePos.y + spriteSize.y};
-        quad[3].texCoords = {spritePos.x, spritePos.y + spriteSize.y};
+        uint32_t value = uint32_t(scratch & ((uint64_t(1) << bits) - 1));
+        scratch >>= bits;
+        scratchBits -= bits;
+        return value;
     }
 
-    void Update() override
+    uint32_t ReadUnsigned()
     {
-        Vector2 mousePos = input->GetMousePos();
-        mousePos.x -= wSize.x / 2.f;
-        mousePos.y -= wSize.y / 2.f;
-        Vector2 position = Vector2(percentPosition.x * wSize.x, percentPosition.y * wSize.y);
-        Vector2 scale = Vector2(percentScale.x * wSize.x / 2.f, percentScale.y * wSize.y / 2.f);
-        bounds = AABB({position, scale});
-        if(bounds.ContainsPoint(mousePos))
+        int bits = Read(6);
+        if(bits > 32)
         {
-            if(input->GetButtonDown(button))
-            {
-                value = !value;
-            }
+            failed = true;
+            return 0;
         }
+        return Read(bits);
     }
 
-    ToggleMode mode = ColourToggle;
-    sf::Color activeColour = sf::Color::White, inactiveColour = sf::Color(0xFF888888);
-    Sprite activeSprite, inactiveSprite;
-    Input::MouseButton button = Input::MouseButton::Left;
-    bool value;
+    int32_t ReadSigned()
+    {
+        uint32_t value = ReadUnsigned();
+        return int32_t(value >> 1) ^ -int32_t(value & 1);
+    }
+
+    bool Failed()
+    {
+        return failed;
+    }
 
 private:
-    Vector2 wSize;
-    AABB bounds;
+    const std::vector<uint8_t>& buffer;
+    size_t position = 0;
+    uint64_t scratch = 0;
+    int scratchBits = 0;
+    bool failed = false;
 };
 
-class TextField : public BaseUIComponent
+// replicates the transforms of registered objects from a server to its clients. the server captures a snapshot each
+// network tick and sends every client only what changed since the last snapshot that client acknowledged, quantized and
+// bit packed, so an idle scene costs a few bytes however many objects it has. clients given a view only hear about
+// objects near it, found through a grid of the registered objects
+class Replicator
 {
 public:
+    // the server's snapshots are sent as changes from one of the last this many, older acknowledgements get a full snapshot
+    static constexpr uint32_t historySize = 32;
+
+    // how finely values are sent, set the same on both ends
+    float positionPrecision = 0.01f;
+    float rotationPrecision = 0.01f;
+    float scalePrecision = 0.001f;
+    // objects enter a client's view once inside it and leave once this far outside, so ones on the edge don't flicker
+    float interestMargin = 64.f;
+    // called on a client for an id it hasn't seen yet, return nullptr to ignore that object until the server despawns it
+    std::function<GameObject*(uint32_t id)> onSpawn;
+    // called on a client when the server stops replicating an object
+    std::function<void(uint32_t id, GameObject* object)> onDespawn;
+
+    // server: starts replicating the object and returns the id clients will know it by
+    uint32_t Add(GameObject* object)
+    {
+        uint32_t id = nextID++;
+        objects[id] = {object};
+        ids[object] = id;
+        return id;
+    }
 
+    // client: ties an id to an object that already exists instead of having onSpawn create it
+    void Bind(uint32_t id, GameObject* object)
+    {
+        objects[id] = {object};
+    }
 
-    TextField(String fontPath = "fonts/default.ttf") : BaseUIComponent()
+    void Remove(uint32_t id)
     {
-        if(!font.loadFromFile(fontPath))
+        auto it = objects.find(id);
+        if(it == objects.end()) return;
+        if(it->second.proxy != SpatialIndex::NoProxy) index.remove(it->second.proxy);
+        ids.erase(it->second.object);
+        objects.erase(it);
+    }
+
+    GameObject* Find(uint32_t id)
+    {
+        auto it = objects.find(id);
+        return it == objects.end() ? nullptr : it->second.object;
+    }
+
+    // server: records the state of every registered object and returns the snapshot's sequence
+    uint32_t Capture()
+    {
+        sequence++;
+        Snapshot& snapshot = history[sequence % historySize];
+        snapshot.sequence = sequence;
+        snapshot.states.clear();
+        for(auto& object : objects)
         {
-            std::cout << "Error: Invalid font" << std::endl;
-            exit(-1);
+            Transform* transform = object.second.object->transform;
+            snapshot.states.push_back(Quantize(object.first, transform));
+            // the grid only hears about objects that moved
+            uint32_t version = transform->GetVersion();
+            if(object.second.proxy == SpatialIndex::NoProxy) object.second.proxy = index.add(object.second.object, AABB(transform->position, {0, 0}));
+            else if(version != object.second.version) index.Update(object.second.proxy, AABB(transform->position, {0, 0}));
+            object.second.version = version;
         }
+        return sequence;
     }
 
-    enum FieldMode
+    // server: the client has this snapshot, so later ones can be sent as changes from it
+    void Acknowledge(uint32_t client, uint32_t snapshot)
     {
-        ColourField, SpriteField
-    };
+        uint32_t& acknowledged = clients[client].acknowledged;
+        if(acknowledged == 0 || int32_t(snapshot - acknowledged) > 0) acknowledged = snapshot;
+    }
 
-    void _render(sf::VertexArray* va, sf::RenderWindow* window, std::vector<sf::Text>* text, std::vector<DebugObj*>* debugDraw) override
+    // server: from now on the client only hears about objects near this area, clients without a view hear about everything
+    void SetView(uint32_t client, AABB view)
     {
-        wSize = {window->getSize()};
+        ClientState& state = clients[client];
+        state.view = view;
+        state.hasView = true;
+    }
 
-        if(mode == ColourField)
+    void ClearView(uint32_t client)
+    {
+        clients[client].hasView = false;
+    }
+
+    void ForgetClient(uint32_t client)
+    {
+        clients.erase(client);
+    }
+
+    // server: writes the latest snapshot into the message body as changes from what the client last acknowledged
+    template <typename T>
+    void Write(uint32_t client, Message<T>& msg)
+    {
+        ClientState& state = clients[client];
+        const Snapshot& current = history[sequence % historySize];
+        const Snapshot* baseline = FindSnapshot(state.acknowledged);
+        const std::vector<ObjectState>* sending = &current.states;
+        const std::vector<ObjectState>* base = baseline != nullptr ? &baseline->states : nullptr;
+        uint32_t slot = current.sequence % historySize;
+        if(state.hasView)
         {
-            sf::RectangleShape rect;
-            Vector2 pos = {wSize.x * (percentPosition.x - percentScale.x * 0.5f), wSize.y * (percentPosition.y - percentScale.y * 0.5f)};
-            Vector2 camPos = camera->getCenter();
-            pos.x += camPos.x;
-            pos.y += camPos.y;
-            Vector2 scale = {wSize.x * percentScale.x, wSize.y * percentScale.y};
-            rect.setPosition(pos.x, pos.y);
-            rect.setSize({scale.x, scale.y});
-            if(selected)
+            // the client's copy of the baseline only has what was relevant to it back then, so writing the same
+            // snapshot again keeps the list it was first written with
+            if(state.lastRelevant != current.sequence || state.relevantSequence[slot] != current.sequence)
             {
-                rect.setFillColor(activeColour);
-                rect.setOutlineColor(activeColour);
+                FindRelevant(state);
+                std::swap(state.relevant[slot], relevantScratch);
+                state.relevantSequence[slot] = current.sequence;
+                state.lastRelevant = current.sequence;
             }
-            else
+            Filter(current.states, state.relevant[slot], visible);
+            sending = &visible;
+            uint32_t baseSlot = baseline != nullptr ? baseline->sequence % historySize : 0;
+            if(baseline != nullptr && state.relevantSequence[baseSlot] == baseline->sequence)
             {
-                rect.setFillColor(inactiveColour);
-                rect.setOutlineColor(inactiveColour);
+                Filter(baseline->states, state.relevant[baseSlot], visibleBase);
+                base = &visibleBase;
             }
-            window->draw(rect);
         }
         else
         {
-            int prevVertices = va->getVertexCount();
-            Sprite sprite;
-            if(selected)
+            state.relevantSequence[slot] = 0;
+        }
+
+        msg.body.clear();
+        msg.reserve(16);
+        BitWriter writer(msg.body);
+        writer.Write(current.sequence, 32);
+        writer.Write(baseline != nullptr ? baseline->sequence : 0, 32);
+        size_t sendCount = sending->size();
+        size_t baseCount = base != nullptr ? base->size() : 0;
+        size_t c = 0, b = 0;
+        uint32_t lastID = 0;
+        // both lists are sorted by id, so one walk finds the new, changed and removed objects
+        while(c < sendCount || b < baseCount)
+        {
+            if(b == baseCount || (c < sendCount && (*sending)[c].id < (*base)[b].id))
             {
-                sprite = activeSprite;
+                WriteState(writer, lastID, (*sending)[c], DefaultState((*sending)[c].id), true);
+                c++;
+            }
+            else if(c == sendCount || (*base)[b].id < (*sending)[c].id)
+            {
+                writer.WriteUnsigned((*base)[b].id - lastID);
+                writer.Write(1, 1);
+                lastID = (*base)[b].id;
+                b++;
             }
             else
             {
-                sprite = inactiveSprite;
+                WriteState(writer, lastID, (*sending)[c], (*base)[b], false);
+                c++;
+                b++;
             }
-            Vector2 spriteSize = sprite.size;
-            Vector2 spritePos = sprite.pos;
-            Vector2 sprScale = {wSize.x * percentScale.x, wSize.y * percentScale.y};
-            Vector2 sprPos = {wSize.x * (percentPosition.x - percentScale.x * 0.5f), wSize.y * (percentPosition.y - percentScale.y * 0.5f)};
-            Vector2 camPos = camera->getCenter();
-            sprPos.x += camPos.x;
-            sprPos.y += camPos.y;
-            va->resize(prevVertices + 4);
-            sf::Vertex* quad = &va[0][prevVertices];
-            quad[0].position = {sprPos.x, sprPos.y};
-            quad[1].position = {sprPos.x + sprScale.x, sprPos.y};
-            quad[2].position = {sprPos.x + sprScale.x, sprPos.y + sprScale.y};
-            quad[3].position = {sprPos.x, sprPos.y + sprScale.y};
-            quad[0].texCoords = {spritePos.x, spritePos.y};
-            quad[1].texCoords = {spritePos.x + spriteSize.x, spritePos.y};
-            quad[2].texCoords = {spritePos.x + spriteSize.x, spritePos.y + spriteSize.y};
-            quad[3].texCoords = {spritePos.x, spritePos.y + spriteSize.y};
-        }
-        sf::Text text1;
-        text1.setCharacterSize(fontSize);
-        text1.setString(this->value);
-        Vector2 wSize = {window->getSize()};
-        Vector2 pos = {wSize.x * percentPosition.x, wSize.y * percentPosition.y};
-        text1.setPosition(pos.x, pos.y);
-        text1.setFont(font);
-        text1.setColor(textColour);
-        if(centred)
+        }
+        // ids only go up, so a step of 0 ends the list
+        writer.WriteUnsigned(0);
+        writer.Flush();
+        msg.header.size = msg.size();
+    }
+
+    // client: applies a snapshot to the objects, returns the sequence to acknowledge or 0 if the message was
+    // older than one already applied or its baseline is no longer known
+    template <typename T>
+    uint32_t Read(const Message<T>& msg)
+    {
+        BitReader reader(msg.body);
+        uint32_t received = reader.Read(32);
+        uint32_t baseSequence = reader.Read(32);
+        if(reader.Failed() || (sequence != 0 && int32_t(received - sequence) <= 0)) return 0;
+        const Snapshot* baseline = nullptr;
+        if(baseSequence != 0)
+        {
+            baseline = FindSnapshot(baseSequence);
+            if(baseline == nullptr) return 0;
+        }
+
+        size_t baseCount = baseline != nullptr ? baseline->states.size() : 0;
+        size_t b = 0;
+        uint32_t id = 0;
+        decoded.clear();
+        while(true)
         {
-            float w = text1.getLocalBounds().width;
-            float h = text1.getLocalBounds().height;
-            text1.setOrigin(w / 2.f, h / 2.f);
+            uint32_t step = reader.ReadUnsigned();
+            if(step == 0 || reader.Failed()) break;
+            id += step;
+            // objects the message doesn't mention are as they were in the baseline
+            while(b < baseCount && baseline->states[b].id < id) decoded.push_back(baseline->states[b++]);
+            ObjectState state = DefaultState(id);
+            if(b < baseCount && baseline->states[b].id == id) state = baseline->states[b++];
+            if(reader.Read(1) == 1) continue;
+            uint32_t changed = reader.Read(fieldCount);
+            for(int i = 0; i < fieldCount; i++)
+            {
+                if(changed & (1 << i)) state.fields[i] = int32_t(uint32_t(state.fields[i]) + uint32_t(reader.ReadSigned()));
+            }
+            decoded.push_back(state);
         }
-        text->push_back(text1);
+        if(reader.Failed()) return 0;
+        while(b < baseCount) decoded.push_back(baseline->states[b++]);
+
+        Apply(FindSnapshot(sequence), decoded);
+        Snapshot& snapshot = history[received % historySize];
+        snapshot.sequence = received;
+        std::swap(snapshot.states, decoded);
+        sequence = received;
+        return received;
     }
 
-    void Update() override
+private:
+    static constexpr int fieldCount = 5;
+
+    // position x and y, rotation, scale x and y, in steps of their precision
+    struct ObjectState
     {
-        if(dt == dtPrev)
+        uint32_t id = 0;
+        int32_t fields[fieldCount] = {0, 0, 0, 0, 0};
+    };
+
+    struct Snapshot
+    {
+        uint32_t sequence = 0;
+        // sorted by id
+        std::vector<ObjectState> states;
+    };
+
+    struct Entry
+    {
+        GameObject* object = nullptr;
+        // where the server keeps it in the interest grid
+        uint32_t proxy = SpatialIndex::NoProxy;
+        uint32_t version = 0;
+    };
+
+    struct ClientState
+    {
+        uint32_t acknowledged = 0;
+        bool hasView = false;
+        AABB view;
+        // the ids sent in each recent snapshot, sorted, relevantSequence is 0 where everything was sent
+        std::vector<uint32_t> relevant[historySize];
+        uint32_t relevantSequence[historySize] = {};
+        uint32_t lastRelevant = 0;
+    };
+
+    // the objects inside the view, plus those within the margin that were already relevant, into relevantScratch
+    void FindRelevant(ClientState& state)
+    {
+        const std::vector<uint32_t>* previous = nullptr;
+        if(state.lastRelevant != 0 && state.relevantSequence[state.lastRelevant % historySize] == state.lastRelevant)
         {
-            return;
+            previous = &state.relevant[state.lastRelevant % historySize];
         }
-        Vector2 mousePos = input->GetMousePos();
-        mousePos.x -= wSize.x / 2.f;
-        mousePos.y -= wSize.y / 2.f;
-        Vector2 position = Vector2(percentPosition.x * wSize.x, percentPosition.y * wSize.y);
-        Vector2 scale = Vector2(percentScale.x * wSize.x / 2.f, percentScale.y * wSize.y / 2.f);
-        bounds = AABB({position, scale});
-        if(bounds.ContainsPoint(mousePos))
+        AABB outer(state.view.center, {state.view.halfDimension.x + interestMargin, state.view.halfDimension.y + interestMargin});
+        index.queryRange(outer, found);
+        relevantScratch.clear();
+        for(GameObject* object : found)
         {
-            selected = true;
-            std::string val = input->GetTextTyped();
-            if(val.size() <= 0)
-            {
-                return;
-                dtPrev = dt;
-            }
-            char c = val.at(0);
-            if(c == '\b')
+            auto id = ids.find(object);
+            if(id == ids.end()) continue;
+            if(state.view.ContainsPoint(object->transform->position) || (previous != nullptr && std::binary_search(previous->begin(), previous->end(), id->second)))
             {
-                if(value.size() <= 0)
-                {
-                    dtPrev = dt;
-                    return;
-                }
-                value.pop_back();
-
-                dtPrev = dt;
-                return;
+                relevantScratch.push_back(id->second);
             }
-            value += c;
         }
-        else selected = false;
-
-        dtPrev = dt;
+        std::sort(relevantScratch.begin(), relevantScratch.end());
     }
 
-    FieldMode mode = ColourField;
-    sf::Color activeColour = sf::Color::White, inactiveColour = sf::Color(0x888888FF);
-    Sprite activeSprite, inactiveSprite;
-    Input::MouseButton button = Input::MouseButton::Left;
-    bool selected = false;
-    std::string value;
-    bool centred = true;
-    sf::Font font;
-    sf::Color textColour;
-    unsigned int fontSize = 14;
-    float dtPrev;
-
-private:
-    Vector2 wSize;
-    AABB bounds;
-};
+    // the states with these ids, looked up rather than walked so the cost follows what the client can see
+    void Filter(const std::vector<ObjectState>& states, const std::vector<uint32_t>& relevant, std::vector<ObjectState>& out)
+    {
+        out.clear();
+        for(uint32_t id : relevant)
+        {
+            auto it = std::lower_bound(states.begin(), states.end(), id, [](const ObjectState& state, uint32_t id)
+            {
+                return state.id < id;
+            });
+            if(it != states.end() && it->id == id) out.push_back(*it);
+        }
+    }
 
-class GameObject
-{
-public:
-    GameObject()
+    ObjectState Quantize(uint32_t id, Transform* transform)
     {
-        components.push_back(new Transform());
-        components[components.size() - 1]->_setup(camera, time, math, input, audio);
-        components[components.size() - 1]->self = this;
-        transform = GetComponent<Transform>();
+        ObjectState state;
+        state.id = id;
+        state.fields[0] = QuantizeValue(transform->position.x, positionPrecision);
+        state.fields[1] = QuantizeValue(transform->position.y, positionPrecision);
+        state.fields[2] = QuantizeValue(transform->rotation, rotationPrecision);
+        state.fields[3] = QuantizeValue(transform->scale.x, scalePrecision);
+        state.fields[4] = QuantizeValue(transform->scale.y, scalePrecision);
+        return state;
     }
 
-    void AddComponent(Script* component)
+    // values too large for a field stick at its ends rather than overflowing
+    static int32_t QuantizeValue(float value, float precision)
     {
-        components.push_back(component);
+        double steps = std::round(double(value) / precision);
+        if(std::isnan(steps)) return 0;
+        steps = std::max<double>(std::numeric_limits<int32_t>::min(), std::min<double>(std::numeric_limits<int32_t>::max(), steps));
+        return int32_t(steps);
+    }
 
-        component->app = app;
-        component->_setup(camera, time, math, input, audio);
-        component->self = this;
-        component->transform = transform;
-        if(created) component->OnCreate();
-        if(started) component->Start();
+    // what a new object is sent as changes from
+    ObjectState DefaultState(uint32_t id)
+    {
+        ObjectState state;
+        state.id = id;
+        state.fields[3] = QuantizeValue(1.f, scalePrecision);
+        state.fields[4] = QuantizeValue(1.f, scalePrecision);
+        return state;
     }
 
-    template <class T>
-    bool HasComponent()
+    // unchanged objects are left out, new ones are always written so the client knows about them
+    void WriteState(BitWriter& writer, uint32_t& lastID, const ObjectState& state, const ObjectState& baseline, bool isNew)
     {
-        for(int i = 0; i < components.size(); i++)
+        uint32_t changed = 0;
+        for(int i = 0; i < fieldCount; i++)
         {
-            if(dynamic_cast<T*>(components[i]) != nullptr) return true;
+            if(state.fields[i] != baseline.fields[i]) changed |= 1 << i;
         }
-        return false;
+        if(changed == 0 && !isNew) return;
+        writer.WriteUnsigned(state.id - lastID);
+        writer.Write(0, 1);
+        writer.Write(changed, fieldCount);
+        for(int i = 0; i < fieldCount; i++)
+        {
+            // the difference wraps the same way the reader's sum does, so it is exact however far apart the values are
+            if(changed & (1 << i)) writer.WriteSigned(int32_t(uint32_t(state.fields[i]) - uint32_t(baseline.fields[i])));
+        }
+        lastID = state.id;
     }
 
-    template <class T>
-    T* GetComponent()
+    // walks the last applied snapshot and the new one together, moving objects whose state differs
+    void Apply(const Snapshot* previous, const std::vector<ObjectState>& states)
     {
-        for(int i = 0; i < components.size(); i++)
+        size_t previousCount = previous != nullptr ? previous->states.size() : 0;
+        size_t p = 0;
+        for(const ObjectState& state : states)
         {
-            if(dynamic_cast<T*>(components[i]) != nullptr)
+            while(p < previousCount && previous->states[p].id < state.id) Despawn(previous->states[p++].id);
+            bool same = false;
+            if(p < previousCount && previous->states[p].id == state.id)
+            {
+                same = std::equal(state.fields, state.fields + fieldCount, previous->states[p].fields);
+                p++;
+            }
+            auto entry = objects.find(state.id);
+            GameObject* object = entry != objects.end() ? entry->second.object : nullptr;
+            bool spawned = false;
+            // ignored objects keep an entry without an object, so onSpawn isn't asked again until they despawn
+            if(entry == objects.end() && onSpawn)
             {
-                return (T*)components[i];
+                object = onSpawn(state.id);
+                objects[state.id] = {object};
+                spawned = true;
             }
+            if(object == nullptr || (same && !spawned)) continue;
+            Transform* transform = object->transform;
+            transform->position = {state.fields[0] * positionPrecision, state.fields[1] * positionPrecision};
+            transform->rotation = state.fields[2] * rotationPrecision;
+            transform->scale = {state.fields[3] * scalePrecision, state.fields[4] * scalePrecision};
+            if(spawned) transform->SnapInterpolation();
+            else transform->MarkMoved();
         }
-        String str = typeid(T).name();
-        std::cout << "Error: component of type '" << str << "' not found" << std::endl;
-        exit(1);
+        while(p < previousCount) Despawn(previous->states[p++].id);
     }
 
-    void AddObject(GameObject* object)
+    void Despawn(uint32_t id)
     {
-        uint32_t id = object->_generateUniqueID(children);
-        children.insert({id, object});
-        object->app = app;
-        object->parent = this;
-        if(!setup) return;
-        object->_setup(camera, time, math, input, audio);
-        object->_onCreate();
-        object->_start();
+        auto it = objects.find(id);
+        if(it == objects.end()) return;
+        GameObject* object = it->second.object;
+        objects.erase(it);
+        if(object != nullptr && onDespawn) onDespawn(id, object);
     }
 
-    void RemoveObject(GameObject* object, bool callOnDestroy = true)
+    const Snapshot* FindSnapshot(uint32_t snapshot)
     {
-        if(object == nullptr) return;
-        if(callOnDestroy) object->_onDestroy();
-        children.erase(object->id);
+        if(snapshot == 0) return nullptr;
+        const Snapshot& found = history[snapshot % historySize];
+        return found.sequence == snapshot ? &found : nullptr;
     }
 
-    void Destroy(bool callOnDestroy = true)
+    // sorted so snapshots come out sorted
+    std::map<uint32_t, Entry> objects;
+    std::unordered_map<GameObject*, uint32_t> ids;
+    SpatialGridHash index;
+    Snapshot history[historySize];
+    std::vector<ObjectState> decoded, visible, visibleBase;
+    std::vector<GameObject*> found;
+    std::vector<uint32_t> relevantScratch;
+    std::unordered_map<uint32_t, ClientState> clients;
+    uint32_t sequence = 0;
+    uint32_t nextID = 1;
+};
+
+// a pool of worker threads that each keep a queue of jobs, stealing from the others once their own runs out
+class JobSystem
+{
+public:
+    JobSystem() {}
+
+    ~JobSystem()
     {
-        parent->RemoveObject(this, callOnDestroy);
+        Stop();
     }
 
-    void _onCreate()
+    // threadCount of 0 uses every hardware thread, the thread calling ParallelFor counts as one of them
+    void Start(unsigned int threadCount = 0)
     {
-        if(!created)
-        created = true;
-        for(int i = 0; i < components.size(); i++)
+        if(!workers.empty()) return;
+        if(threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+        for(unsigned int i = 0; i < threadCount; i++)
         {
-            components[i]->OnCreate();
+            queues.push_back(std::make_unique<Queue>());
+        }
+        running = true;
+        // the last queue belongs to the calling thread
+        for(unsigned int i = 0; i + 1 < threadCount; i++)
+        {
+            workers.emplace_back([this, i]() { _work(i); });
         }
     }
 
-    void _onDestroy()
+    void Stop()
     {
-        for(int i = 0; i < components.size(); i++)
         {
-            components[i]->OnDestroy();
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            running = false;
         }
-        auto it = children.begin();
-        while(it != children.end())
+        wake.notify_all();
+        for(size_t i = 0; i < workers.size(); i++)
         {
-            children[it->first]->_onDestroy();
-            it++;
+            workers[i].join();
         }
-        components.clear();
+        workers.clear();
+        queues.clear();
     }
 
-    void _start()
+    unsigned int ThreadCount() const
     {
-        if(!started)
-        started = true;
-        for(int i = 0; i < components.size(); i++)
-        {
-            components[i]->Start();
-        }
+        return workers.size() + 1;
     }
 
-    void _update()
+    // calls fn(begin, end) over [0, count) in chunks and returns once they have all run, only call from one thread at a time
+    void ParallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)> &fn)
     {
-        if(!enabled)
+        if(count == 0) return;
+        if(workers.empty() || count <= chunkSize)
         {
+            fn(0, count);
             return;
         }
-        for(int i = 0; i < components.size(); i++)
+        task = &fn;
+        size_t chunks = (count + chunkSize - 1) / chunkSize;
+        remaining.store(chunks);
+        for(size_t c = 0; c < chunks; c++)
         {
-            components[i]->simulated = simulated;
-            components[i]->dt = dt;
-            components[i]->Update();
+            Queue &queue = *queues[c % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back({c * chunkSize, std::min(count, (c + 1) * chunkSize)});
         }
-        auto it = children.begin();
-        while(it != children.end())
         {
-            children[it->first]->simulated = simulated;
-            children[it->first]->dt = dt;
-            children[it->first]->_update();
-            it++;
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            generation++;
+        }
+        wake.notify_all();
+        _drain(queues.size() - 1);
+        // everything has been taken, wait for the chunks still running on other threads
+        while(remaining.load() > 0)
+        {
+            std::this_thread::yield();
         }
     }
 
-    void _setup(sf::View* camera, Time* time, Math* math, Input* input, Audio* audio)
+private:
+    struct Job
     {
-        if(setup) return;
-        setup = true;
-        this->camera = camera;
-        this->time = time;
-        this->math = math;
-        this->input = input;
-        this->audio = audio;
+        size_t begin, end;
+    };
 
-        for(int i = 0; i < components.size(); i++)
-        {
-            components[i]->_setup(camera, time, math, input, audio);
-            components[i]->OnCreate();
-        }
-    }
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
 
-    void _qt(QuadTree* qt)
+    void _work(unsigned int index)
     {
-        if(!enabled)
-        {
-            return;
-        }
-        Vector2 halfDim;
-        if(HasComponent<SpriteRenderer>()) halfDim = GetComponent<SpriteRenderer>()->sprite.size;
-        else halfDim = {1, 1};
-        halfDim.x /= 2.f;
-        halfDim.y /= 2.f;
-        if(!qt->insert(this, AABB(transform->position, {halfDim.x * transform->scale.x, halfDim.y * transform->scale.y})))
+        uint64_t seen = 0;
+        while(true)
         {
-            std::cout << "Error: could not insert object into the quadtree" << std::endl;
-            std::cout << "OBJECTS     | " << qt->getCountAll() << "\n"; 
-            std::cout << "POSITION    | " << transform->position <<
-                       "\nSCALE       | " << transform->scale <<
-                       "\nROTATION    | " << transform->rotation <<
-                       "\nCOMPONENTS  | " << components.size() << std::endl;
-            for(int i = 0; i < components.size(); i++)
             {
-                std::cout <<
-                       "\nCOMPONENT " << i << " |" << typeid(*components[i]).name();
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                wake.wait(lock, [&]() { return !running || generation != seen; });
+                if(!running) return;
+                seen = generation;
             }
-            std::cout << std::endl;
-            exit(2);
-        }
-        auto it = children.begin();
-        while(it != children.end())
-        {
-            children[it->first]->_qt(qt);
-            it++;
+            _drain(index);
         }
     }
 
-    void _render(sf::VertexArray* va, sf::RenderWindow* window, std::vector<sf::Text>* text, std::vector<DebugObj*>* debugDraw)
+    void _drain(unsigned int index)
     {
-        if(!enabled)
-        {
-            return;
-        }
-        if(!HasComponent<Drawable>())
-        {
-            return;
-        }
-        for(int i = 0; i < components.size(); i++)
+        Job job;
+        while(_pop(index, job) || _steal(index, job))
         {
-            if(dynamic_cast<Drawable*>(components[i]) != nullptr)
-            {
-                dynamic_cast<Drawable*>(components[i])->_render(va, window, text, debugDraw);
-            }
+            (*task)(job.begin, job.end);
+            remaining.fetch_sub(1);
         }
     }
 
-    uint32_t _generateUniqueID(std::map<uint32_t, GameObject*>* objects)
+    // takes the newest job from a thread's own queue
+    bool _pop(unsigned int index, Job &job)
     {
-        uint32_t id = std::chrono::system_clock::now().time_since_epoch().count();
-        while(objects->count(id) != 0)
+        Queue &queue = *queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(queue.jobs.empty()) return false;
+        job = queue.jobs.back();
+        queue.jobs.pop_back();
+        return true;
+    }
+
+    // takes the oldest job from any other thread's queue
+    bool _steal(unsigned int index, Job &job)
+    {
+        for(unsigned int i = 1; i < queues.size(); i++)
         {
-            id += 0xe120fc15;
-            uint64_t tmp;
-            tmp = (uint64_t)id * 0x4a39b70d;
-            uint32_t m1 = (tmp >> 32) ^ tmp;
-            tmp = (uint64_t)m1 * 0x12fad5c9;
-            uint32_t m2 = (tmp >> 32) ^ tmp;
-            id = m2;
+            Queue &queue = *queues[(index + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if(queue.jobs.empty()) continue;
+            job = queue.jobs.front();
+            queue.jobs.pop_front();
+            return true;
         }
-        this->id = id;
-        return id;
+        return false;
     }
 
-    GameObject* parent;
-    Application* app;
-    sf::View* camera;
-    Transform* transform;
-    Time* time;
-    Math* math;
-    Input* input;
-    Audio* audio;
-    uint32_t id;
-    float dt;
-    bool simulated;
-    float _timer;
-    bool enabled = true;
-
-private:
-    std::map<uint32_t, GameObject*> children;
-    std::vector<Script*> components;
-    bool created = false, started = false, setup = false;
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Queue>> queues;
+    const std::function<void(size_t, size_t)>* task = nullptr;
+    std::atomic<size_t> remaining{0};
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    uint64_t generation = 0;
+    bool running = false;
 };
 
 class Application
@@ -2331,6 +6904,7 @@ public:
     Application() {}
 
     virtual void OnCreate() {}
+    // call transform->MarkMoved() on anything moved here, only scripts have their moves noticed for them
     virtual void OnUpdate() {}
     virtual void OnDestroy()
     {
@@ -2399,10 +6973,14 @@ public:
     {
         uint32_t id = object->_generateUniqueID(gameObjects);
         gameObjects.insert({id, object});
-        object->simulated = true;
+        gameObjectsChanged = true;
+        // the next broad phase refresh decides whether it's inside the simulation distance
+        object->simulated = false;
         object->parent = nullptr;
         object->app = this;
-        object->_setup(&camera, &time, &math, &input, &audio);
+        object->_setInScene(true);
+        object->transform->MarkMoved();
+        object->_setup(&camera, &time, &math, &input, &audio, &textures);
         object->_onCreate();
         object->_start();
     }
@@ -2410,8 +6988,100 @@ public:
     void RemoveObject(GameObject* object, bool callOnDestroy = true)
     {
         if(object == nullptr) return;
+        object->_indexRemove();
+        object->_setInScene(false);
+        _forgetSimulated();
         if(callOnDestroy) object->_onDestroy();
         gameObjects.erase(object->id);
+        gameObjectsChanged = true;
+    }
+
+    // drops everything that has left the scene from the simulated list, so nothing there can be deleted before the next refresh
+    void _forgetSimulated()
+    {
+        auto removed = std::remove_if(gameObjectsSimulated.begin(), gameObjectsSimulated.end(), [](GameObject* object) { return !object->_inScene; });
+        for(auto it = removed; it != gameObjectsSimulated.end(); it++)
+        {
+            (*it)->simulated = false;
+        }
+        gameObjectsSimulated.erase(removed, gameObjectsSimulated.end());
+    }
+
+    // runs Update on this frame's batch, then LateUpdate on the main thread once every Update has finished
+    void _updateObjects()
+    {
+        if(jobs.ThreadCount() > 1)
+        {
+            // scripts that aren't thread safe run on the main thread first, then the rest are spread over the workers
+            parallelBatch.clear();
+            for(size_t i = 0; i < updateBatch.size(); i++)
+            {
+                if(updateBatch[i]->_threadSafe()) parallelBatch.push_back(updateBatch[i]);
+                else updateBatch[i]->_update();
+            }
+            jobs.ParallelFor(parallelBatch.size(), 32, [this](size_t begin, size_t end)
+            {
+                for(size_t i = begin; i < end; i++)
+                {
+                    parallelBatch[i]->_update();
+                }
+            });
+        }
+        else
+        {
+            for(size_t i = 0; i < updateBatch.size(); i++)
+            {
+                updateBatch[i]->_update();
+            }
+        }
+        for(size_t i = 0; i < updateBatch.size(); i++)
+        {
+            updateBatch[i]->_lateUpdate();
+        }
+        // scripts can move other objects in the batch, so this waits until every one has run
+        for(size_t i = 0; i < updateBatch.size(); i++)
+        {
+            updateBatch[i]->_detectMoves();
+        }
+    }
+
+    // fills out with every object whose bounds intersect range, using whichever broad phase is selected
+    void QueryBroadPhase(const AABB &range, std::vector<GameObject*> &out)
+    {
+        index->queryRange(range, out);
+    }
+
+    // moves only the objects whose transform changed since the last refresh, then finds everything inside the simulation distance
+    void _refreshBroadPhase()
+    {
+        if(index == nullptr)
+        {
+            if(broadPhase == GridBroadPhase) index = new SpatialGridHash(gridCellSize);
+            else index = new QuadTree(quadTreeBounds);
+        }
+        GameObject::_refreshIndex(index);
+        for(size_t i = 0; i < gameObjectsSimulated.size(); i++)
+        {
+            gameObjectsSimulated[i]->simulated = false;
+        }
+        QueryBroadPhase(simulationDistance, gameObjectsSimulated);
+        for(size_t i = 0; i < gameObjectsSimulated.size(); i++)
+        {
+            gameObjectsSimulated[i]->simulated = true;
+        }
+        // the emulated list holds every top level object, the update loop skips the simulated and disabled ones
+        if(gameObjectsChanged)
+        {
+            gameObjectsChanged = false;
+            gameObjectsEmulated.clear();
+            auto it = gameObjects.begin();
+            while(it != gameObjects.end())
+            {
+                gameObjectsEmulated.push_back(it->second);
+                it++;
+            }
+            emulatedIT = 0;
+        }
     }
 
     void Exit(int status = 0)
@@ -2427,29 +7097,269 @@ public:
     bool fullscreen = false, vsync = true, showFps = true;
     sf::Color bgColour = sf::Color::Black;
     AABB simulationDistance = AABB({0, 0}, {windowWidth * 0.6, windowHeight * 0.6});
+    enum BroadPhase
+    {
+        QuadTreeBroadPhase, GridBroadPhase
+    };
+
+    // GridBroadPhase suits lots of similarly sized sprites, only read when the application starts
+    BroadPhase broadPhase = QuadTreeBroadPhase;
+    // should be around the size of a typical object, only read when the application starts
+    float gridCellSize = 256.f;
+    // should cover most of the world, the tree doubles in size whenever an object leaves it, only read when the application starts
+    AABB quadTreeBounds = AABB({0, 0}, {100000, 100000});
     // the time between updates for objects outside of the simulation distance
     float emulatedTargetDeltaTime = 1.f;
     // the time between updates for objects inside of the simulation distance
     float simulatedTargetDeltaTime = (1 / 60.f);
+    enum TimeStep
+    {
+        VariableTimeStep, FixedTimeStep
+    };
+
+    // FixedTimeStep updates every simulated object together once per simulatedTargetDeltaTime, only read when the application starts
+    TimeStep timeStep = VariableTimeStep;
+    // with FixedTimeStep, the most ticks run in one frame before the simulation gives up on catching up
+    int maxTicksPerFrame = 5;
+    // with FixedTimeStep, draw sprites between their last two ticks instead of where the latest one left them
+    bool interpolate = true;
+    // updates objects whose scripts are all threadSafe on a pool of worker threads, only read when the application starts
+    bool multithreaded = false;
+    // 0 uses every hardware thread, only read when the application starts
+    unsigned int jobThreads = 0;
+    // in pixels per second per second, y points down the screen
+    Vector2 gravity = {0, 0};
+    // more settles piles and stacks better, each one is another pass over every contact
+    int solverIterations = 8;
+    // bodies slower than this, in pixels per second, for timeToSleep seconds along with everything they touch go to sleep
+    float sleepVelocity = 5.f;
+    // in radians per second, bodies turning faster than this don't count as slow
+    float sleepAngularVelocity = 0.05f;
+    float timeToSleep = 0.5f;
 
     Time time;
     Math math;
     Input input;
     Audio audio;
+    // load images here in OnCreate, they are packed into atlas pages when the application starts
+    TextureManager textures;
+    // stats for the last rendered frame
+    RenderStats renderStats;
 
 private:
     sf::RenderWindow window;
     std::map<uint32_t, GameObject*> gameObjects;
     std::vector<GameObject*> gameObjectsSimulated;
     std::vector<GameObject*> gameObjectsEmulated;
-    QuadTree* qt;
+    SpatialIndex* index = nullptr;
+    bool gameObjectsChanged = false;
+    // the collision broad phase, separate from the index since it only holds colliders
+    SweepAndPrune sweep;
+    ContactSolver solver;
+    Islands islands;
+    // the awake rigid bodies stepped this collision tick
+    std::vector<RigidBody*> bodies;
+    // the colliders inside the simulation distance that aren't asleep, put in the sweep again every tick
+    std::vector<Collider*> sweeping;
+    // ids of colliders whose contacts the solver kept while they slept, to be let go of after this tick
+    std::vector<uint32_t> forgotten;
+    // objects outside the simulation distance that the stepped bodies could be touching
+    std::vector<GameObject*> nearby;
+    // the objects due an update this frame, reused so the update system doesn't allocate
+    std::vector<GameObject*> updateBatch;
+    std::vector<GameObject*> parallelBatch;
+    JobSystem jobs;
     sf::View camera;
+    RenderBatch batch;
     sf::Texture tex;
     bool texLoaded = false;
-    float simulatedInterval = 0, simulatedTimer = 0; int simulatedIT = 0;
-    float emulatedInterval = 0, emulatedTimer = 0; int emulatedIT = 0;
+    float simulatedInterval = 0, simulatedTimer = 0; size_t simulatedIT = 0;
+    float emulatedInterval = 0, emulatedTimer = 0; size_t emulatedIT = 0;
+    float fixedTimer = 0;
+    bool fixedStep = false;
     float targetFPS = 60.0f;
 
+    // adds the emulated objects that are due an update to the batch, they take turns so only a few run each frame
+    void _collectEmulated()
+    {
+        if(gameObjectsEmulated.size() > 0)
+        {
+            size_t emulatedCount = 0;
+            while(emulatedTimer > emulatedInterval)
+            {
+                if(emulatedIT >= gameObjectsEmulated.size()) emulatedIT = 0;
+                if(gameObjectsEmulated[emulatedIT]->simulated || !gameObjectsEmulated[emulatedIT]->enabled || emulatedCount >= gameObjectsEmulated.size())
+                {
+                    emulatedIT++;
+                    emulatedTimer -= emulatedInterval;
+                    continue;
+                }
+                gameObjectsEmulated[emulatedIT]->dt = gameObjectsEmulated[emulatedIT]->_timer;
+                gameObjectsEmulated[emulatedIT]->_timer = 0;
+                updateBatch.push_back(gameObjectsEmulated[emulatedIT]);
+                emulatedCount++;
+                emulatedIT++;
+                emulatedTimer -= emulatedInterval;
+            }
+        }
+    }
+
+    // runs as many whole ticks as have built up, every simulated object is updated once per tick with the same dt
+    void _fixedUpdate()
+    {
+        int ticks = 0;
+        while(fixedTimer >= simulatedTargetDeltaTime)
+        {
+            if(ticks == maxTicksPerFrame)
+            {
+                // too far behind to catch up, drop the backlog instead of spending longer on it every frame
+                fixedTimer = std::fmod(fixedTimer, simulatedTargetDeltaTime);
+                break;
+            }
+            Transform::_beginTick();
+            _refreshBroadPhase();
+            auto it = gameObjects.begin();
+            while(it != gameObjects.end())
+            {
+                if(gameObjects[it->first]->enabled) gameObjects[it->first]->_timer += simulatedTargetDeltaTime;
+                it++;
+            }
+            updateBatch.clear();
+            for(size_t i = 0; i < gameObjectsSimulated.size(); i++)
+            {
+                // children are in the broad phase too, but they are updated by their parent's _update
+                if(!gameObjectsSimulated[i]->enabled || gameObjectsSimulated[i]->parent != nullptr) continue;
+                gameObjectsSimulated[i]->dt = simulatedTargetDeltaTime;
+                gameObjectsSimulated[i]->_timer = 0;
+                updateBatch.push_back(gameObjectsSimulated[i]);
+            }
+            if(gameObjectsEmulated.size() > 0) emulatedInterval = emulatedTargetDeltaTime / gameObjectsEmulated.size();
+            emulatedTimer += simulatedTargetDeltaTime;
+            _collectEmulated();
+            _updateObjects();
+            _collide();
+            fixedTimer -= simulatedTargetDeltaTime;
+            ticks++;
+        }
+        // presses are kept until a tick has seen them
+        if(ticks > 0) input._update();
+        Transform::_alpha() = interpolate ? fixedTimer / simulatedTargetDeltaTime : 1.f;
+    }
+
+    // one physics step: gravity and forces, then the sweep finds the overlapping pairs, the solver turns them into
+    // velocity changes, the bodies move by their velocities, and islands that have come to rest go to sleep
+    void _collide()
+    {
+        float dt = simulatedTargetDeltaTime;
+        bodies.clear();
+        sweeping.clear();
+        for(size_t i = 0; i < gameObjectsSimulated.size(); i++)
+        {
+            GameObject* object = gameObjectsSimulated[i];
+            RigidBody* body = object->HasComponent<RigidBody>() ? object->GetComponent<RigidBody>() : nullptr;
+            if(body != nullptr && body->_sleeping && body->_disturbed()) body->WakeUp();
+            // sleeping bodies keep whatever they were touching when they fell asleep, and stay in the sweep where they fell
+            // asleep without being looked at again until something wakes them
+            if(body != nullptr && body->_sleeping)
+            {
+                if(object->_indexProxy == SpatialIndex::NoProxy) continue;
+                if(body->collider->_sweepProxy == SpatialIndex::NoProxy) _sweepCollider(body->collider);
+                else sweep.Keep(body->collider->_sweepProxy);
+                continue;
+            }
+            Collider* collider = body != nullptr ? body->collider : object->HasComponent<Collider>() ? object->GetComponent<Collider>() : nullptr;
+            if(collider != nullptr)
+            {
+                collider->IsColliding = false;
+                if(object->_indexProxy != SpatialIndex::NoProxy) sweeping.push_back(collider);
+            }
+            if(body != nullptr)
+            {
+                if(body->_resting)
+                {
+                    // what was kept from when it fell asleep warm starts this tick, then goes
+                    body->_resting = false;
+                    forgotten.push_back(collider->_id);
+                }
+                body->_integrateVelocity(gravity, dt);
+                bodies.push_back(body);
+            }
+        }
+        islands.Begin(bodies);
+        // only the colliders inside the simulation distance go in the sweep, plus whatever just outside it the stepped bodies overlap
+        float far = std::numeric_limits<float>::max();
+        Vector2 reachMin = {far, far}, reachMax = {-far, -far};
+        for(size_t i = 0; i < sweeping.size(); i++)
+        {
+            Collider* collider = sweeping[i];
+            AABB bounds = _sweepCollider(collider);
+            if(collider->_body == nullptr || collider->_body->_island == RigidBody::NoIsland) continue;
+            reachMin = {std::min(reachMin.x, bounds.center.x - bounds.halfDimension.x), std::min(reachMin.y, bounds.center.y - bounds.halfDimension.y)};
+            reachMax = {std::max(reachMax.x, bounds.center.x + bounds.halfDimension.x), std::max(reachMax.y, bounds.center.y + bounds.halfDimension.y)};
+        }
+        if(reachMin.x <= reachMax.x && index != nullptr)
+        {
+            index->queryRange(AABB({(reachMin.x + reachMax.x) / 2.f, (reachMin.y + reachMax.y) / 2.f}, {(reachMax.x - reachMin.x) / 2.f, (reachMax.y - reachMin.y) / 2.f}), nearby);
+            for(size_t i = 0; i < nearby.size(); i++)
+            {
+                if(!nearby[i]->simulated && nearby[i]->HasComponent<Collider>()) _sweepCollider(nearby[i]->GetComponent<Collider>());
+            }
+        }
+        sweep.RemoveUntouched();
+        sweep.TakeRemoved(forgotten);
+
+        const std::vector<SweepAndPrune::Pair> &pairs = sweep.FindPairs();
+        solver.Begin();
+        for(size_t i = 0; i < pairs.size(); i++)
+        {
+            Collider* a = pairs[i].a;
+            Collider* b = pairs[i].b;
+            // only the bodies stepped this tick move, the rest are solid like static colliders
+            RigidBody* bodyA = a->_body != nullptr && a->_body->_island != RigidBody::NoIsland ? a->_body : nullptr;
+            RigidBody* bodyB = b->_body != nullptr && b->_body->_island != RigidBody::NoIsland ? b->_body : nullptr;
+            if(bodyA == nullptr && bodyB == nullptr) continue;
+            Collider::Collision collision = a->_test(b);
+            if(!collision.HasCollision) continue;
+            // a sleeping body that gets hit is solid for the rest of this tick and moves again from the next
+            if(bodyA == nullptr && a->_body != nullptr && a->_body->_sleeping) a->_body->WakeUp();
+            if(bodyB == nullptr && b->_body != nullptr && b->_body->_sleeping) b->_body->WakeUp();
+            if(bodyA != nullptr && bodyB != nullptr) islands.Link(bodyA, bodyB);
+            solver.Add(a, bodyA, b, bodyB, collision);
+        }
+        solver.Solve(dt, solverIterations);
+        solver.Forget(forgotten);
+
+        for(size_t i = 0; i < bodies.size(); i++)
+        {
+            bodies[i]->_integratePosition(dt);
+        }
+        islands.Sleep(bodies, dt, sleepVelocity, sleepAngularVelocity, timeToSleep);
+        islands.End(bodies);
+        solver.Sleep();
+        // bodies that just fell asleep stay in the sweep with the bounds they have now, as static
+        for(size_t i = 0; i < bodies.size(); i++)
+        {
+            Collider* collider = bodies[i]->collider;
+            if(bodies[i]->_sleeping && collider->_sweepProxy != SpatialIndex::NoProxy) sweep.Update(collider->_sweepProxy, collider->_worldBounds(), true);
+        }
+    }
+
+    // puts the collider in the sweep or moves it there, returning its bounds
+    AABB _sweepCollider(Collider* collider)
+    {
+        // only the bodies stepped this tick move, everything else is paired like a static collider
+        bool moves = collider->_body != nullptr && collider->_body->_island != RigidBody::NoIsland;
+        bool sleeping = collider->_body != nullptr && collider->_body->_sleeping;
+        AABB bounds = collider->_worldBounds();
+        if(collider->_sweepProxy == SpatialIndex::NoProxy)
+        {
+            sweep.SetStatic(sweep.Add(collider, bounds), !moves);
+        }
+        else if(sleeping) sweep.SetStatic(collider->_sweepProxy, true);
+        else sweep.Update(collider->_sweepProxy, bounds, !moves);
+        return bounds;
+    }
+
     void start()
     {
         if(spriteFilePath != "default.png")
@@ -2461,6 +7371,9 @@ private:
             }
             texLoaded = true;
         }
+        textures._pack();
+        if(multithreaded) jobs.Start(jobThreads);
+        fixedStep = timeStep == FixedTimeStep;
         sf::Clock clock;
         sf::Time t;
         float lastTime = 0;
@@ -2471,7 +7384,6 @@ private:
         float frameTimer = 0;
         float actualFrameTimer = 0.f;
         float fpsLast = 0;
-        qt = new QuadTree({{0, 0}, {100000, 100000}});
         input._setup();
 
         camera = sf::View({0, 0}, {windowWidth, windowHeight});
@@ -2485,34 +7397,15 @@ private:
                 actualFrameTimer -= timeBetweenFrames;
 
                 //quadtree manager
-                if(refreshTimer >= simulatedTargetDeltaTime)
+                if(!fixedStep && refreshTimer >= simulatedTargetDeltaTime)
                 {
-                    qt->clear();
-                    auto it = gameObjects.begin();
-                    while(it != gameObjects.end())
-                    {
-                        if(gameObjects[it->first]->enabled) gameObjects[it->first]->_qt(qt);
-                        gameObjects[it->first]->simulated = false;
-                        it++;
-                    }
-                    gameObjectsSimulated = qt->queryRange(simulationDistance);
-                    for(int i = 0; i < gameObjectsSimulated.size(); i++)
-                    {
-                        if(gameObjectsSimulated[i] == nullptr) exit(2);
-                        gameObjectsSimulated[i]->simulated = true;
-                    }
-                    it = gameObjects.begin();
-                    while(it != gameObjects.end())
-                    {
-                        if(!gameObjects[it->first]->simulated && gameObjects[it->first]->enabled) gameObjectsEmulated.push_back(gameObjects[it->first]);
-                        it++;
-                    }
+                    _refreshBroadPhase();
                     refreshTimer -= simulatedTargetDeltaTime;
                 }
 
 
                 //event handler
-                if(simulatedTimer >= simulatedTargetDeltaTime)
+                if(!fixedStep && simulatedTimer >= simulatedTargetDeltaTime)
                 {
                     input._update();
                 }
@@ -2533,73 +7426,50 @@ private:
                 simulationDistance.center = camera.getCenter();
                 simulationDistance.halfDimension = {camera.getSize().x * 0.55f, camera.getSize().y * 0.55f};
                 OnUpdate();
-                auto it = gameObjects.begin();
-                while(it != gameObjects.end())
+                if(fixedStep)
                 {
-                    if(gameObjects[it->first]->enabled) gameObjects[it->first]->_timer += time.deltaTime;
-                    it++;
+                    _fixedUpdate();
                 }
-                if(gameObjectsSimulated.size() > 0)
+                else
                 {
-                    while(simulatedTimer >= simulatedInterval)
+                    auto it = gameObjects.begin();
+                    while(it != gameObjects.end())
                     {
-                        if(simulatedIT >= gameObjectsSimulated.size()) simulatedIT = 0;
-                        gameObjectsSimulated[simulatedIT]->dt = gameObjectsSimulated[simulatedIT]->_timer;
-                        gameObjectsSimulated[simulatedIT]->_timer = 0;
-                        gameObjectsSimulated[simulatedIT]->_update();
-                        simulatedIT++;
-                        simulatedTimer -= simulatedInterval;
+                        if(gameObjects[it->first]->enabled) gameObjects[it->first]->_timer += time.deltaTime;
+                        it++;
                     }
-                }
-                if(gameObjectsEmulated.size() > 0)
-                {
-                    while(emulatedTimer > emulatedInterval)
+                    updateBatch.clear();
+                    if(gameObjectsSimulated.size() > 0)
                     {
-                        if(emulatedIT >= gameObjectsEmulated.size()) emulatedIT = 0;
-                        gameObjectsEmulated[emulatedIT]->dt = gameObjectsEmulated[emulatedIT]->_timer;
-                        gameObjectsEmulated[emulatedIT]->_timer = 0;
-                        gameObjectsEmulated[emulatedIT]->_update();
-                        emulatedIT++;
-                        emulatedTimer -= emulatedInterval;
+                        size_t simulatedCount = 0;
+                        while(simulatedTimer >= simulatedInterval)
+                        {
+                            if(simulatedIT >= gameObjectsSimulated.size()) simulatedIT = 0;
+                            // an object only goes in once, a second pass in the same frame would have had a dt of 0. children are
+                            // updated by their parent's _update, so batching them as well would run their scripts twice
+                            if(simulatedCount < gameObjectsSimulated.size())
+                            {
+                                if(gameObjectsSimulated[simulatedIT]->parent == nullptr)
+                                {
+                                    gameObjectsSimulated[simulatedIT]->dt = gameObjectsSimulated[simulatedIT]->_timer;
+                                    gameObjectsSimulated[simulatedIT]->_timer = 0;
+                                    updateBatch.push_back(gameObjectsSimulated[simulatedIT]);
+                                }
+                                simulatedCount++;
+                            }
+                            simulatedIT++;
+                            simulatedTimer -= simulatedInterval;
+                        }
                     }
+                    _collectEmulated();
+                    _updateObjects();
                 }
 
 
                 //collision handler
-                if(collisionTimer >= simulatedTargetDeltaTime)
+                if(!fixedStep && collisionTimer >= simulatedTargetDeltaTime)
                 {
-                    std::vector<GameObject*> rbs;
-                    for(int i = 0; i < gameObjectsSimulated.size(); i++)
-                    {
-                        if(gameObjectsSimulated[i]->HasComponent<Collider>())
-                        {
-                            gameObjectsSimulated[i]->GetComponent<Collider>()->IsColliding = false;
-                        }
-                        if(gameObjectsSimulated[i]->HasComponent<RigidBody>())
-                        {
-                            rbs.push_back(gameObjectsSimulated[i]);
-                        }
-                    }
-                    for(int i = 0; i < rbs.size(); i++)
-                    {
-                        RigidBody* rb = rbs[i]->GetComponent<RigidBody>();
-                        Vector2 pos = {rb->transform->position.x + rb->collider->Centre.x, rb->transform->position.y + rb->collider->Centre.y};
-                        Vector2 size;
-                        if(rb->collider->Type == Collider::Poly) size = {rb->transform->scale.x * rb->collider->Scale.x * rb->collider->bounds.halfDimension.x * 2.f, rb->transform->scale.y * rb->collider->Scale.y * rb->collider->bounds.halfDimension.y * 2.f};
-                        else size = {rb->collider->Radius * 1.5f * rb->transform->scale.x * rb->collider->Scale.x, rb->collider->Radius * 1.5f * rb->transform->scale.y * rb->collider->Scale.y};
-                        size.x *= 2.f;
-                        size.y *= 2.f;
-                        std::vector<GameObject*> broadPhaseCheck = qt->queryRange({pos, size});
-                        std::vector<Collider*> colliders;
-                        for(int i = 0; i < broadPhaseCheck.size(); i++)
-                        {
-                            if(broadPhaseCheck[i]->HasComponent<Collider>())
-                            {
-                                colliders.push_back(broadPhaseCheck[i]->GetComponent<Collider>());
-                            }
-                        }
-                        rb->_checkCollisions(colliders);
-                    }
+                    _collide();
                     collisionTimer -= simulatedTargetDeltaTime;
                 }
 
@@ -2609,58 +7479,15 @@ private:
                 {
                     window.setView(camera);
                     window.clear(bgColour);
-                    sf::VertexArray* va = new sf::VertexArray(sf::Quads, 0);
-                    std::vector<sf::Text>* text = new std::vector<sf::Text>();
-                    std::vector<DebugObj*>* debugDraw = new std::vector<DebugObj*>();
-                    std::cout << gameObjectsSimulated.size() << "\n";
+                    batch.Begin();
                     for(int i = 0; i < gameObjectsSimulated.size(); i++)
                     {
-                        gameObjectsSimulated[i]->_render(va, &window, text, debugDraw);
-                    }
-                    if(va->getVertexCount() > 0)
-                    {
-                        sf::RenderStates state = sf::RenderStates::Default;
-                        if(texLoaded)
-                        {
-                            state.texture = &tex;
-                        }
-                        window.draw(&va[0][0], va->getVertexCount(), sf::Quads, state);
-                    }
-                    delete va;
-                    for(int i = 0; i < text->size(); i++)
-                    {
-                        window.draw(text->at(i));
-                    }
-                    text->clear();
-                    delete text;
-                    for(int i = 0; i < debugDraw->size(); i++)
-                    {
-                        DebugObj* obj = debugDraw->at(i);
-                        if(obj->rect != nullptr)
-                        {
-                            window.draw(*obj->rect);
-                            delete obj->rect;
-                        }
-                        if(obj->circle != nullptr)
-                        {
-                            window.draw(*obj->circle);
-                            delete obj->circle;
-                        }
-                        if(obj->text != nullptr)
-                        {
-                            window.draw(*obj->text);
-                            delete obj->text;
-                        }
-                        if(obj->va != nullptr)
-                        {
-                            window.draw(*obj->va);
-                            delete obj->va;
-                        }
-                        delete obj;
+                        gameObjectsSimulated[i]->_render(&batch, &window);
                     }
+                    batch.Draw(&window, texLoaded ? &tex : nullptr, &textures);
+                    renderStats = batch.stats;
                     window.display();
                     frameTimer -= (1.f / targetFPS);
-                    delete debugDraw;
                 }
                 sleep(timeBetweenFrames * 0.001f);
             }
@@ -2678,6 +7505,7 @@ private:
             frameTimer += time.deltaTime;
             collisionTimer += time.deltaTime;
             actualFrameTimer += time.deltaTime;
+            if(fixedStep) fixedTimer += time.deltaTime;
 
             timer += time.deltaTime;
             if(timer >= 0.5)
@@ -2699,4 +7527,9 @@ private:
     }
 };
 
+inline void _forgetSimulated(Application* app)
+{
+    if(app != nullptr) app->_forgetSimulated();
+}
+
 #endif